@@ -6,6 +6,7 @@
 #include "ClockProcess.h"
 
 #include "rtx.h"
+#include "Timer.h"
 #include "Utilities/String.h"
 
 #include <LPC17xx.h>
@@ -14,6 +15,9 @@
 #include "printf.h"
 #endif /* DEBUG_0 */
 
+extern volatile uint32_t g_timer_count;
+extern int g_UsedCount;
+
 /**
  * Clock process initialization table item. Initialized with values on an
  * initializeClockProcess() call.
@@ -21,9 +25,9 @@
 PROC_INIT g_ClockProcess;
 
 /**
- * String representation of the wall clock time, +3 for "\n\r\0".
+ * String representation of the wall clock time, +1 for "\0".
  */
-static char s_ClockDisplay[CLOCK_STRING_LENGTH + 3];
+static char s_ClockDisplay[CLOCK_STRING_LENGTH + 1];
 
 /**
  * Flag to indicate whether to ignore the next delayed message that comes in
@@ -42,6 +46,64 @@ static int s_IsRunning;
  */
 static U32 s_WallClock;
 
+/**
+ * Timer and idle tick counts at the last status report, used to work out the
+ * CPU load over the last report period.
+ */
+static U32 s_LastReportTicks;
+static U32 s_LastIdleTicks;
+
+/**
+ * Text last sent for each status region, +1 for "\0". Regions start out blank.
+ */
+static char s_LastStatus[NUM_STATUS_REGIONS][STATUS_REGION_WIDTH + 1];
+
+/**
+ * Sends new text for a status region to the CRT. Nothing is sent if the
+ * region already shows this text.
+ */
+static void sendStatus(int region, char text[]) {
+    Letter* status;
+
+    if (strequals(text, s_LastStatus[region])) {
+        return;
+    }
+    strcpy(text, s_LastStatus[region]);
+
+    status = (Letter*)request_memory_block();
+
+    status->m_Type = STATUS_UPDATE;
+    status->m_Text[0] = '0' + region;
+    strcpy(text, &(status->m_Text[1]));
+    send_message(CRT_PROCESS, (void*)status);
+}
+
+/**
+ * Reports the CPU load since the last report and the memory pool usage to the
+ * status line.
+ */
+static void reportStatus(void) {
+    char text[STATUS_REGION_WIDTH + 1];
+    U32 ticks = g_timer_count - s_LastReportTicks;
+    U32 idle = getIdleTickCount() - s_LastIdleTicks;
+    int n;
+
+    s_LastReportTicks += ticks;
+    s_LastIdleTicks += idle;
+
+    strcpy("CPU ", text);
+    n = 4 + strdecimal((ticks == 0 || idle > ticks) ? 0 : 100 - idle * 100 / ticks, &(text[4]));
+    strcpy("%", &(text[n]));
+    sendStatus(STATUS_CPU_LOAD, text);
+
+    strcpy("MEM ", text);
+    n = 4 + strdecimal(g_UsedCount, &(text[4]));
+    text[n] = '/';
+    n++;
+    strdecimal(NUM_BLOCKS, &(text[n]));
+    sendStatus(STATUS_MEMORY, text);
+}
+
 void initializeClockProcess(void) {
     g_ClockProcess.m_pid = (U32)CLOCK_PROCESS;
     g_ClockProcess.m_priority = PRIVILEGED;
@@ -50,7 +112,7 @@ void initializeClockProcess(void) {
 }
 
 void resetClock(void) {
-    strcpy("00:00:00\r\n", s_ClockDisplay);
+    strcpy("00:00:00", s_ClockDisplay);
     s_WallClock = 0;
 }
 
@@ -62,6 +124,7 @@ void runClockProcess(void) {
     Letter* registerCommandWS;
     Letter* registerCommandWT;
     Letter* registerCommandWR;
+    Letter* statusTick;
 #endif /* !DEBUG_PERFORMANCE */
     
     // initialize flags
@@ -90,6 +153,14 @@ void runClockProcess(void) {
     registerCommandWR->m_Type = KCD_REG;
     strcpy("%WR", registerCommandWR->m_Text);
     send_message(KCD_PROCESS, (void*)registerCommandWR);
+
+    // report CPU load and memory usage to the status line every second
+    s_LastReportTicks = g_timer_count;
+    s_LastIdleTicks = getIdleTickCount();
+    statusTick = (Letter*)request_memory_block();
+    statusTick->m_Type = REPORT;
+    statusTick->m_Text[0] = '\0';
+    delayed_send(CLOCK_PROCESS, (void*)statusTick, 1000);
 #endif /* !DEBUG_PERFORMANCE */
     
     while (1) {
@@ -128,26 +199,26 @@ void runClockProcess(void) {
                     if (s_IsRunning) {
                         s_IsRunning = 0;
                         s_IgnoreNext = 1;
+                        sendStatus(STATUS_CLOCK, "");
                     }
 
                     strcpy("\r\n", message->m_Text);
                     send_message(CRT_PROCESS, (void*)message);
                 }
             }
+        } else if (sender == CLOCK_PROCESS && message->m_Type == REPORT) { // status report tick
+            reportStatus();
+            delayed_send(CLOCK_PROCESS, (void*)message, 1000);
         } else if (sender == CLOCK_PROCESS) { // received a message from ourself
             if (s_IsRunning && !s_IgnoreNext) {
-                Letter* toCRT;
                 updateClock(); // increment clock
                 
                 // a second has passed since we last ran
                 // relay the message back to ourselves with a delay of 1 second
                 delayed_send(CLOCK_PROCESS, (void*)message, 1000);
                 
-                // send a new message to the CRT to display the time
-                toCRT = (Letter*)request_memory_block();
-                toCRT->m_Type = DEFAULT;
-                strcpy(s_ClockDisplay, toCRT->m_Text);
-                send_message(CRT_PROCESS, (void*)toCRT);
+                // redraw the time on the status line
+                sendStatus(STATUS_CLOCK, s_ClockDisplay);
             } else {
                 s_IgnoreNext = 0;
                 release_memory_block((void*)message); // release memory of ignored message
@@ -167,17 +238,19 @@ int setClock(char command[]) {
         && command[9] == ':'
         && command[10] >= '0' && command[10] <= '5'
         && command[11] >= '0' && command[11] <= '9'
-        && ((command[4] == '0' || command[4] == '1') && (command[5] >= '0' && command[5] <= '9'))
-                || (command[4] == '2' && (command[5] >= '0' && command[5] <= '3'))) {
+        && (((command[4] == '0' || command[4] == '1') && (command[5] >= '0' && command[5] <= '9'))
+                || (command[4] == '2' && (command[5] >= '0' && command[5] <= '3')))) {
+            int i;
                     
             s_WallClock = ((command[4] - '0') * 10 + command[5] - '0') * 3600 +
                     ((command[7] - '0') * 10 + command[8] - '0') * 60 +
                     ((command[10] - '0') * 10 + command[11] - '0');
             
-            strcpy(&(command[4]), s_ClockDisplay);
-            s_ClockDisplay[8] = '\n';
-            s_ClockDisplay[9] = '\r';
-            s_ClockDisplay[10] = '\0';
+            // copy just the time; anything after it is ignored
+            for (i = 0; i < CLOCK_STRING_LENGTH; i++) {
+                s_ClockDisplay[i] = command[4 + i];
+            }
+            s_ClockDisplay[CLOCK_STRING_LENGTH] = '\0';
                     
             return 1; // success
     } else {
@@ -188,10 +261,10 @@ int setClock(char command[]) {
 void startRelay(Letter* toCRT) {
     Letter* toWallClock; // create a message to send to ourself
     
-    // print out the current time
+    // end the command line and show the current time on the status line
     strcpy("\r\n", toCRT->m_Text);
-    strcpy(s_ClockDisplay, &(toCRT->m_Text[2]));
     send_message(CRT_PROCESS, (void*)toCRT);
+    sendStatus(STATUS_CLOCK, s_ClockDisplay);
     
     toWallClock = (Letter*)request_memory_block();
     
@@ -226,9 +299,7 @@ void updateClock() {
         s_ClockDisplay[4] = minute % 10 + '0';
         s_ClockDisplay[6] = second / 10 + '0';
         s_ClockDisplay[7] = second % 10 + '0';
-        s_ClockDisplay[8] = '\n';
-        s_ClockDisplay[9] = '\r';
-        s_ClockDisplay[10] = '\0';
+        s_ClockDisplay[8] = '\0';
     } else {
         // reset wall clock if we try to increment it from 23:59:59
         resetClock();
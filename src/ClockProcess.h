@@ -41,10 +41,10 @@ int setClock(char command[]);
 
 /**
  * Starts the loop of self-sent delayed messages, which will allow the wall
- * clock to update itself every second.
+ * clock to update itself every second. The time is shown in the clock status
+ * region.
  * 
- * @param   toCRT The letter containing the string representation of the
- *                current time to be displayed (sent to the CRT to be printed).
+ * @param   toCRT A letter to reuse for ending the command line on the CRT.
  */
 void startRelay(Letter* toCRT);
 
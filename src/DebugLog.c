@@ -0,0 +1,109 @@
+/**
+ * @file:   DebugLog.c
+ * @brief:  Buffered, interrupt driven debug output on UART1
+ */
+
+#include "DebugLog.h"
+
+#include "k_critical.h"
+#include "UART.h"
+
+#include <LPC17xx.h>
+
+/**
+ * Debug output ring buffer. The ring is empty when s_LogHead == s_LogTail and
+ * holds at most DEBUG_LOG_SIZE - 1 characters. It is zero-initialized at
+ * startup, so printf can be used before initializeDebugLog().
+ */
+static char s_LogBuffer[DEBUG_LOG_SIZE];
+
+/**
+ * Index of the ring position into which the next character is written.
+ */
+static volatile int s_LogHead;
+
+/**
+ * Index of the next character to write to the TX FIFO.
+ */
+static volatile int s_LogTail;
+
+/**
+ * Number of characters dropped because the ring was full.
+ */
+static U32 s_LogDrops;
+
+/**
+ * Writes up to UART_FIFO_SIZE characters from the ring to the TX FIFO.
+ *
+ * @return  The number of characters written.
+ */
+static int drainDebugLog(LPC_UART_TypeDef* pUart) {
+    int count = 0;
+
+    while (count < UART_FIFO_SIZE && s_LogTail != s_LogHead) {
+        pUart->THR = s_LogBuffer[s_LogTail];
+        s_LogTail = (s_LogTail + 1) % DEBUG_LOG_SIZE;
+        count++;
+    }
+    return count;
+}
+
+void flushDebugLog(void) {
+    LPC_UART_TypeDef* pUart = (LPC_UART_TypeDef*)LPC_UART1;
+    U32 criticalSection;
+
+    if (s_LogTail == s_LogHead) {
+        return;
+    }
+
+    // while THRE is enabled the interrupt owns the transmitter
+    criticalSection = enterCriticalSection();
+    if (!(pUart->IER & IER_THRE) && (pUart->LSR & LSR_THRE)) {
+        drainDebugLog(pUart);
+        pUart->IER |= IER_THRE;
+    }
+    exitCriticalSection(criticalSection);
+}
+
+U32 getDebugLogDropCount(void) {
+    return s_LogDrops;
+}
+
+void initializeDebugLog(void) {
+    uart1_irq_init();
+    LPC_UART1->IER = 0; // transmit only; THRE is enabled on each flush
+}
+
+void logPutc(void* p, char c) {
+    U32 criticalSection;
+    int next;
+
+    // the ring is shared by the kernel, processes and interrupt handlers
+    criticalSection = enterCriticalSection();
+    next = (s_LogHead + 1) % DEBUG_LOG_SIZE;
+    if (next == s_LogTail) {
+        s_LogDrops++;
+    } else {
+        s_LogBuffer[s_LogHead] = c;
+        s_LogHead = next;
+    }
+    exitCriticalSection(criticalSection);
+}
+
+/**
+ * @brief: UART1 IRQ Handler
+ * NOTE: The handler never switches processes, so it needs no assembly
+ *       wrapper to preserve the remaining registers.
+ */
+void UART1_IRQHandler(void) {
+    LPC_UART_TypeDef* pUart = (LPC_UART_TypeDef*)LPC_UART1;
+    uint8_t IIR_IntId = ((pUart->IIR) >> 1) & 0x07; // reading IIR acknowledges the interrupt
+
+    if (IIR_IntId == IIR_THRE) {
+        if (drainDebugLog(pUart) == 0) {
+            pUart->IER &= ~IER_THRE; // ring is empty; the next flush restarts it
+        }
+    } else if (IIR_IntId == IIR_RLS) {
+        (void)pUart->LSR;
+    }
+}
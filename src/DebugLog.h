@@ -0,0 +1,41 @@
+/**
+ * @file:   DebugLog.h
+ * @brief:  Buffered, interrupt driven debug output on UART1
+ */
+
+#ifndef _DEBUG_LOG_
+#define _DEBUG_LOG_
+
+#include "Utilities/Types.h"
+
+/**
+ * Starts transmitting buffered debug output if the transmitter is idle. Called
+ * from the null process; the UART1 TX interrupt keeps the transmission going
+ * until the buffer is empty.
+ */
+void flushDebugLog(void);
+
+/**
+ * Gets the number of debug output characters dropped because the buffer was
+ * full.
+ * 
+ * @return  The number of dropped characters since startup.
+ */
+U32 getDebugLogDropCount(void);
+
+/**
+ * Initializes UART1 for interrupt driven debug output. Output written before
+ * this call stays buffered until the first flush.
+ */
+void initializeDebugLog(void);
+
+/**
+ * Callback for printf. Appends a character to the debug output buffer without
+ * waiting for the UART; the character is dropped if the buffer is full.
+ * 
+ * @param   p Unused, must be NULL.
+ * @param   c The character to write.
+ */
+void logPutc(void* p, char c);
+
+#endif /* _DEBUG_LOG_ */
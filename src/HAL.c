@@ -13,6 +13,17 @@ __asm void __rte(void)
   BX   LR
 }
 
+/* PendSV is the deferred kernel context (lowest priority). Save the other
+   registers so the C handler can switch processes, as in the IRQ handlers */
+__asm void PendSV_Handler(void)
+{
+  PRESERVE8
+  IMPORT c_PendSV_Handler
+  PUSH {R4-R11, LR}
+  BL   c_PendSV_Handler
+  POP  {R4-R11, PC}
+}
+
 /* NOTE: assuming MSP is used. Ideally, PSP should be used */
 __asm void SVC_Handler (void) 
 {
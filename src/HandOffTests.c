@@ -0,0 +1,335 @@
+/**
+ * @file:   HandOffTests.c
+ * @brief:  Unit tests for the memory hand-off and the process lifecycle.
+ */
+
+#include "HandOffTests.h"
+
+#include "Polling/uart_polling.h"
+#include "rtx.h"
+
+#ifdef DEBUG_0
+#include "printf.h"
+#endif /* DEBUG_0 */
+
+#define FAIL 0
+#define PASS 1
+
+#define NUM_HAND_OFF_TESTS 8
+
+/**
+ * Test process initialization table items. Initialized with values on a
+ * set_test_procs() call.
+ */
+PROC_INIT g_test_procs[NUM_TEST_PROCS];
+
+// for testing
+extern int g_AvailableCount;
+
+/**
+ * Blocks held by handOffController(), and how many of them it has.
+ */
+static void* s_Hoard[USER_BLOCK_QUOTA];
+static int s_Hoarded;
+
+/**
+ * Blocks held by handOffHoarder(), and how many of them it has.
+ */
+static void* s_HoarderBlocks[USER_BLOCK_QUOTA];
+static int s_HoarderTaken;
+
+/**
+ * Block handOffController() sends itself to wait a while.
+ */
+static void* s_TimerLetter;
+
+/**
+ * Memory pressure notices handOffController() received, in order.
+ */
+static int s_Notices[2];
+static int s_NoticeCount;
+
+/**
+ * Blocks released to the waiters, and the blocks the waiters got, in the
+ * order A, B, C.
+ */
+static void* s_Released[3];
+static void* s_Got[3];
+
+/**
+ * Flag set by handOffChild().
+ */
+static int s_ChildRan;
+
+/**
+ * Flag set once handOffController() has finished.
+ */
+static int s_Completed;
+
+/**
+ * Array for storing test results.
+ */
+static int s_Passed[NUM_HAND_OFF_TESTS];
+
+/**
+ * Test names, printed with the results.
+ */
+static char* s_TestNames[NUM_HAND_OFF_TESTS] = {
+    "Hand-off block",
+    "Hand-off without switch",
+    "Hand-off order",
+    "Exit process",
+    "Create process",
+    "Create task",
+    "Reclaim memory",
+    "Memory watermarks"
+};
+
+/*
+ * Tests:
+ * 1) Hand-off block: handOffController() and handOffHoarder() take blocks
+ *    until user requests wait, then handOffController() releases a block
+ *    while the three waiters wait
+ *        Pass conditions:
+ *        - handOffWaiterA(), the highest priority waiter, gets that very block
+ *        - the hand-off is counted in the memory stats
+ * 2) Hand-off without switch
+ *        Pass conditions:
+ *        - no waiter runs before handOffController() blocks, since none
+ *          outranks it
+ *        - the handed blocks do not go back to the free count
+ * 3) Hand-off order: two more blocks are released
+ *        Pass conditions:
+ *        - handOffWaiterB() gets the first, as it waited longer than
+ *          handOffWaiterC() at the same priority
+ *        - handOffWaiterC() gets the second
+ * 4) Exit process: each waiter exits holding its block
+ *        Pass conditions:
+ *        - the waiters' priorities can no longer be read
+ *        - their blocks are back in the free count
+ * 5) Create process: handOffController() creates handOffChild() at MEDIUM
+ *        Pass conditions:
+ *        - create_process() returns a process ID
+ *        - the child runs only once handOffController() blocks, then exits
+ * 6) Create task
+ *        Pass conditions:
+ *        - create_task() is refused to a user process
+ * 7) Reclaim memory
+ *        Pass conditions:
+ *        - reclaim_memory() is refused to a user process
+ * 8) Memory watermarks: handOffController() subscribes to memory pressure
+ *    before the blocks are taken
+ *        Pass conditions:
+ *        - set_memory_watermarks() is refused to a user process
+ *        - taking the blocks sends MEM_LOW; releasing them sends MEM_OK
+ */
+
+void set_test_procs() {
+    int i;
+
+    for (i = 0; i < NUM_TEST_PROCS; i++) {
+        g_test_procs[i].m_pid = (U32)(i + 1);
+        g_test_procs[i].m_stack_size = 0x100;
+    }
+
+    g_test_procs[0].m_priority = HIGH;
+    g_test_procs[1].m_priority = HIGH;
+    g_test_procs[2].m_priority = MEDIUM;
+    g_test_procs[3].m_priority = LOW;
+    g_test_procs[4].m_priority = LOW;
+    g_test_procs[5].m_priority = LOWEST;
+
+    g_test_procs[0].mpf_start_pc = &handOffController;
+    g_test_procs[1].mpf_start_pc = &handOffHoarder;
+    g_test_procs[2].mpf_start_pc = &handOffWaiterA;
+    g_test_procs[3].mpf_start_pc = &handOffWaiterB;
+    g_test_procs[4].mpf_start_pc = &handOffWaiterC;
+    g_test_procs[5].mpf_start_pc = &handOffResults;
+
+    for (i = 0; i < NUM_HAND_OFF_TESTS; i++) {
+        s_Passed[i] = PASS;
+    }
+    for (i = 0; i < 3; i++) {
+        s_Got[i] = NULL;
+    }
+    s_Hoarded = 0;
+    s_HoarderTaken = 0;
+    s_NoticeCount = 0;
+    s_ChildRan = 0;
+    s_Completed = 0;
+}
+
+/**
+ * Blocks handOffController() for a few milliseconds, so that lower priority
+ * processes run. Memory pressure notices that arrive meanwhile are recorded.
+ */
+static void waitAWhile(void) {
+    Letter* message;
+
+    delayed_send(PROCESS_1, s_TimerLetter, 10);
+    while ((message = (Letter*)receive_message(NULL)) != s_TimerLetter) {
+        if (s_NoticeCount < 2) {
+            s_Notices[s_NoticeCount] = message->m_Type;
+            s_NoticeCount++;
+        }
+        release_memory_block(message);
+    }
+}
+
+/**
+ * Task handler for the create_task() test; never registered.
+ */
+static void handOffTask(void* message, int sender_id) {
+    release_memory_block(message);
+}
+
+void handOffController(void) {
+    MemoryStats stats;
+    U32 handOvers;
+    int pid;
+    int i;
+
+    subscribe_memory_pressure(1);
+    s_TimerLetter = request_memory_block();
+
+    // with handOffHoarder(), take blocks until the rest are reserved, so that
+    // user requests wait
+    while (g_AvailableCount > MEMORY_RESERVE && s_Hoarded < USER_BLOCK_QUOTA - 1) {
+        s_Hoard[s_Hoarded] = request_memory_block();
+        s_Hoarded++;
+    }
+    waitAWhile(); // handOffHoarder() takes the rest, then the waiters request a block each
+    get_memory_stats(PROCESS_1, &stats);
+    handOvers = stats.m_HandOvers;
+
+    // release a block to each waiter; none of them outranks this process
+    for (i = 0; i < 3; i++) {
+        s_Hoarded--;
+        s_Released[i] = s_Hoard[s_Hoarded];
+        release_memory_block(s_Released[i]);
+        if (s_Got[0] != NULL || s_Got[1] != NULL || s_Got[2] != NULL
+                || g_AvailableCount != MEMORY_RESERVE) {
+            s_Passed[1] = FAIL;
+        }
+    }
+    get_memory_stats(PROCESS_1, &stats);
+    if (stats.m_HandOvers != handOvers + 3) {
+        s_Passed[0] = FAIL;
+    }
+
+    waitAWhile(); // the waiters take their blocks and exit
+    if (s_Got[0] != s_Released[0]) {
+        s_Passed[0] = FAIL;
+    }
+    if (s_Got[1] != s_Released[1] || s_Got[2] != s_Released[2]) {
+        s_Passed[2] = FAIL;
+    }
+    if (get_process_priority(PROCESS_3) != RTX_ERR
+            || get_process_priority(PROCESS_4) != RTX_ERR
+            || get_process_priority(PROCESS_5) != RTX_ERR
+            || g_AvailableCount != MEMORY_RESERVE + 3) {
+        s_Passed[3] = FAIL;
+    }
+
+    while (s_Hoarded > 0) {
+        s_Hoarded--;
+        release_memory_block(s_Hoard[s_Hoarded]);
+    }
+    for (i = 0; i < s_HoarderTaken; i++) {
+        release_memory_block(s_HoarderBlocks[i]);
+    }
+
+    pid = create_process(&handOffChild, MEDIUM, 0x100);
+    if (pid == RTX_ERR || s_ChildRan) {
+        s_Passed[4] = FAIL;
+    }
+    waitAWhile(); // the child runs and exits
+    if (!s_ChildRan || get_process_priority(pid) != RTX_ERR) {
+        s_Passed[4] = FAIL;
+    }
+
+    if (create_task(&handOffTask) != RTX_ERR) {
+        s_Passed[5] = FAIL;
+    }
+
+    if (reclaim_memory(PROCESS_2) != RTX_ERR) {
+        s_Passed[6] = FAIL;
+    }
+
+    if (set_memory_watermarks(MEMORY_LOW_WATERMARK, MEMORY_HIGH_WATERMARK) != RTX_ERR) {
+        s_Passed[7] = FAIL;
+    }
+    if (s_NoticeCount != 2 || s_Notices[0] != MEM_LOW || s_Notices[1] != MEM_OK) {
+        s_Passed[7] = FAIL;
+    }
+    subscribe_memory_pressure(0);
+
+    // handOffResults() prints once this process blocks
+    s_Completed = 1;
+    while (1) {
+        release_memory_block(receive_message(NULL));
+    }
+}
+
+void handOffHoarder(void) {
+    while (1) {
+        while (g_AvailableCount > MEMORY_RESERVE && s_HoarderTaken < USER_BLOCK_QUOTA) {
+            s_HoarderBlocks[s_HoarderTaken] = request_memory_block();
+            s_HoarderTaken++;
+        }
+
+        // handOffController() releases the blocks
+        release_memory_block(receive_message(NULL));
+    }
+}
+
+void handOffResults(void) {
+    int completed = 0;
+    int i;
+
+    while (1) {
+        // print results once handOffController() has completed
+        if (!completed && s_Completed) {
+            for (i = 0; i < NUM_HAND_OFF_TESTS; i++) {
+                uart1_put_string(s_TestNames[i]);
+                if (s_Passed[i] == PASS) {
+                    uart1_put_string(": OK");
+                } else {
+                    uart1_put_string(": FAILED");
+                }
+                uart1_put_string("\r\n");
+            }
+
+            completed = 1;
+        }
+        release_processor();
+    }
+}
+
+void handOffWaiterA(void) {
+    while (1) {
+        s_Got[0] = request_memory_block();
+        exit_process(); // releases the block
+    }
+}
+
+void handOffWaiterB(void) {
+    while (1) {
+        s_Got[1] = request_memory_block();
+        exit_process(); // releases the block
+    }
+}
+
+void handOffWaiterC(void) {
+    while (1) {
+        s_Got[2] = request_memory_block();
+        exit_process(); // releases the block
+    }
+}
+
+void handOffChild(void) {
+    while (1) {
+        s_ChildRan = 1;
+        exit_process();
+    }
+}
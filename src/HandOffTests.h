@@ -0,0 +1,50 @@
+/**
+ * @file:   HandOffTests.h
+ * @brief:  Unit tests for the memory hand-off and the process lifecycle.
+ */
+
+#ifndef _HAND_OFF_TESTS_
+#define _HAND_OFF_TESTS_
+
+/*
+ * Sets test processes to hand-off tests.
+ */
+void set_test_procs(void);
+
+/*
+ * Process that runs the tests, releasing blocks to the waiters.
+ */
+void handOffController(void);
+
+/*
+ * Process that takes blocks alongside handOffController().
+ */
+void handOffHoarder(void);
+
+/*
+ * Process to print test results.
+ */
+void handOffResults(void);
+
+/*
+ * Medium priority process that waits for a block, then exits.
+ */
+void handOffWaiterA(void);
+
+/*
+ * Low priority process that waits for a block, then exits.
+ */
+void handOffWaiterB(void);
+
+/*
+ * Low priority process that waits for a block after handOffWaiterB(), then
+ * exits.
+ */
+void handOffWaiterC(void);
+
+/*
+ * Process created by handOffController(), which exits straight away.
+ */
+void handOffChild(void);
+
+#endif /* _HAND_OFF_TESTS_ */
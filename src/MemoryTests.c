@@ -37,18 +37,18 @@ static int s_Passed[3] = { PASS };
 
 /*
  * Tests:
- * 1) Deplete memory: request all memory blocks
+ * 1) Deplete quota: request all the memory blocks a user process may hold
  *        Pass conditions:
- *        - g_UsedCount = NUM_BLOCKS
- *        - g_AvailableCount = 0
- *        - request() is blocked
+ *        - g_UsedCount = USER_BLOCK_QUOTA
+ *        - g_AvailableCount = NUM_BLOCKS - USER_BLOCK_QUOTA
+ *        - request() is blocked on its quota
  * 2) Release memory success
  *        Pass conditions:
  *        - all release_memory_block() operations return sucess
  * 3) Release some memory
  *        Pass conditions:
- *        - g_UsedCount != NUM_BLOCKS
- *        - g_AvailableCount != 0
+ *        - g_UsedCount != USER_BLOCK_QUOTA
+ *        - g_AvailableCount != NUM_BLOCKS - USER_BLOCK_QUOTA
  *        - request() is unblocked
  *         
 */
@@ -89,13 +89,14 @@ void request(void) {
             s_Passed[0] = FAIL;
         }
         
-        for (i = 0; i < NUM_BLOCKS + 1; i++) { // request the number of available blocks + 1
-            // this will block when i = 40, until a memory block is released
+        for (i = 0; i < USER_BLOCK_QUOTA + 1; i++) { // request the quota + 1
+            // this will block when i = 16, until one of these blocks is released
             s_MemoryBlocks[i] = (U32)request_memory_block();
         }
         
-        // assert g_UsedCount = 40 and g_AvailableCount = 0
-        if (g_UsedCount != NUM_BLOCKS || g_AvailableCount != 0) {
+        // assert g_UsedCount = 16 and g_AvailableCount = 24
+        // (release() freed one block, which this process took again)
+        if (g_UsedCount != USER_BLOCK_QUOTA || g_AvailableCount != NUM_BLOCKS - USER_BLOCK_QUOTA) {
             s_Passed[0] = FAIL;
         }
         
@@ -109,8 +110,8 @@ void release(void) {
         int i;
         int release = 10; // release 10 memory blocks
         
-        // assert g_UsedCount = 40 and g_AvailableCount = 0
-        if (g_UsedCount != NUM_BLOCKS || g_AvailableCount != 0) {
+        // assert g_UsedCount = 16 and g_AvailableCount = 24
+        if (g_UsedCount != USER_BLOCK_QUOTA || g_AvailableCount != NUM_BLOCKS - USER_BLOCK_QUOTA) {
             s_Passed[0] = FAIL;
         }
         
@@ -121,8 +122,8 @@ void release(void) {
             }
         }
         
-        // assert g_UsedCount = 31 and g_AvailableCount = 9
-        if (g_UsedCount != NUM_BLOCKS - release + 1 || g_AvailableCount != release - 1) {
+        // assert g_UsedCount = 7 and g_AvailableCount = 33
+        if (g_UsedCount != USER_BLOCK_QUOTA - release + 1 || g_AvailableCount != NUM_BLOCKS - USER_BLOCK_QUOTA + release - 1) {
             s_Passed[2] = FAIL;
         }
         
@@ -43,12 +43,12 @@ __asm void TIMER1_IRQHandler(void)
  * @brief: c TIMER0 IRQ Handler
  */
 void c_TIMER1_IRQHandler(void) {
-    __disable_irq();
+    // runs above the kernel ceiling and only touches its own counter, so no
+    // masking is needed
 
     // acknowledge interrupt, see section  21.6.1 on pg 493 of LPC17XX_UM
     LPC_TIM1->IR = BIT(0);  
     
     // increment timer
     g_PerformanceTimerCount++;
-    __enable_irq();
 }
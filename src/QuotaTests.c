@@ -0,0 +1,296 @@
+/**
+ * @file:   QuotaTests.c
+ * @brief:  Unit tests for memory quotas and the reserved pools.
+ */
+
+#include "QuotaTests.h"
+
+#include "Polling/uart_polling.h"
+#include "rtx.h"
+
+#ifdef DEBUG_0
+#include "printf.h"
+#endif /* DEBUG_0 */
+
+#define FAIL 0
+#define PASS 1
+
+#define NUM_QUOTA_TESTS 5
+
+/**
+ * Test process initialization table items. Initialized with values on a
+ * set_test_procs() call.
+ */
+PROC_INIT g_test_procs[NUM_TEST_PROCS];
+
+// for testing
+extern int g_AvailableCount;
+
+/**
+ * Blocks held by quotaHolder().
+ */
+static void* s_QuotaBlocks[USER_BLOCK_QUOTA + 1];
+
+/**
+ * Blocks held by quotaRefunder(), and how many of them it has.
+ */
+static void* s_ExtraBlocks[USER_BLOCK_QUOTA];
+static int s_ExtraTaken;
+
+/**
+ * Blocks held by reserveTaker(), and how many of them it has.
+ */
+static void* s_ReserveBlocks[USER_BLOCK_QUOTA];
+static int s_ReserveTaken;
+
+/**
+ * Block reserveTaker() takes for reserveChecker() to time its wait with.
+ */
+static void* s_TimerLetter;
+
+/**
+ * How far quotaHolder() has got, for quotaRefunder() to follow.
+ */
+static int s_QuotaStep;
+
+/**
+ * Flags set just before the blocked process is woken.
+ */
+static int s_Refunded;
+static int s_ReserveChecked;
+
+/**
+ * Number of test processes that have finished.
+ */
+static int s_Done;
+
+/**
+ * Array for storing test results.
+ */
+static int s_Passed[NUM_QUOTA_TESTS];
+
+/**
+ * Test names, printed with the results.
+ */
+static char* s_TestNames[NUM_QUOTA_TESTS] = {
+    "Memory quota",
+    "Quota refund wake-up",
+    "Quota waits for own blocks",
+    "User reserve limit",
+    "System reserve use"
+};
+
+/*
+ * Tests:
+ * 1) Memory quota
+ *        Pass conditions:
+ *        - set_memory_quota() is refused to a user process
+ *        - get_memory_usage() reports no blocks and a quota of
+ *          USER_BLOCK_QUOTA for quotaHolder()
+ * 2) Quota refund wake-up: quotaHolder() takes its quota, then waits in
+ *    BLOCKED_QUOTA for one more block, until quotaRefunder() releases one of
+ *    its blocks
+ *        Pass conditions:
+ *        - quotaHolder() gets its block only after the refund
+ *        - quotaHolder() is charged USER_BLOCK_QUOTA blocks again
+ * 3) Quota waits for own blocks: while quotaHolder() waits, quotaRefunder()
+ *    releases a block charged to itself
+ *        Pass conditions:
+ *        - quotaHolder() keeps waiting
+ * 4) User reserve limit: with quotaHolder() and quotaRefunder() holding
+ *    blocks, reserveTaker() takes blocks until it waits in BLOCKED_MEM
+ *        Pass conditions:
+ *        - g_AvailableCount = MEMORY_RESERVE while it waits
+ *        - every block it took is charged to it
+ * 5) System reserve use: while reserveTaker() waits, the clock process sends
+ *    its next status report
+ *        Pass conditions:
+ *        - the fewest free blocks went below MEMORY_RESERVE (a system process
+ *          took a reserved block)
+ *        - but not below IPROCESS_RESERVE
+ */
+
+void set_test_procs() {
+    int i;
+
+    for (i = 0; i < NUM_TEST_PROCS; i++) {
+        g_test_procs[i].m_pid = (U32)(i + 1);
+        g_test_procs[i].m_stack_size = 0x100;
+    }
+
+    g_test_procs[0].m_priority = HIGH;
+    g_test_procs[1].m_priority = HIGH;
+    g_test_procs[2].m_priority = MEDIUM;
+    g_test_procs[3].m_priority = LOW;
+    g_test_procs[4].m_priority = LOW;
+    g_test_procs[5].m_priority = LOW;
+
+    g_test_procs[0].mpf_start_pc = &quotaHolder;
+    g_test_procs[1].mpf_start_pc = &quotaRefunder;
+    g_test_procs[2].mpf_start_pc = &reserveTaker;
+    g_test_procs[3].mpf_start_pc = &reserveChecker;
+    g_test_procs[4].mpf_start_pc = &quotaResults;
+    g_test_procs[5].mpf_start_pc = &quotaDummy;
+
+    for (i = 0; i < NUM_QUOTA_TESTS; i++) {
+        s_Passed[i] = PASS;
+    }
+    s_QuotaStep = 0;
+    s_Refunded = 0;
+    s_ReserveChecked = 0;
+    s_ExtraTaken = 0;
+    s_ReserveTaken = 0;
+    s_Done = 0;
+}
+
+void quotaHolder(void) {
+    int quota;
+    int i;
+
+    while (1) {
+        if (set_memory_quota(PROCESS_1, NUM_BLOCKS) != RTX_ERR) {
+            s_Passed[0] = FAIL;
+        }
+        if (get_memory_usage(PROCESS_1, &quota) != 0 || quota != USER_BLOCK_QUOTA) {
+            s_Passed[0] = FAIL;
+        }
+
+        for (i = 0; i < USER_BLOCK_QUOTA; i++) {
+            s_QuotaBlocks[i] = request_memory_block();
+        }
+
+        // over quota: waits until quotaRefunder() releases s_QuotaBlocks[0]
+        s_QuotaStep = 1;
+        s_QuotaBlocks[USER_BLOCK_QUOTA] = request_memory_block();
+        if (!s_Refunded || get_memory_usage(PROCESS_1, NULL) != USER_BLOCK_QUOTA) {
+            s_Passed[1] = FAIL;
+        }
+        s_QuotaStep = 2;
+        s_Done++;
+
+        // lower priority, effectively inactivates this process; its blocks
+        // are left for reserveTaker() to release
+        set_process_priority(PROCESS_1, LOWEST);
+    }
+}
+
+void quotaRefunder(void) {
+    void* block;
+
+    while (1) {
+        while (s_QuotaStep != 1) {
+            release_processor();
+        }
+
+        // a block charged to this process does not refund quotaHolder()
+        block = request_memory_block();
+        release_memory_block(block);
+        release_processor();
+        if (s_QuotaStep != 1 || get_memory_usage(PROCESS_1, NULL) != USER_BLOCK_QUOTA) {
+            s_Passed[2] = FAIL;
+        }
+
+        s_Refunded = 1;
+        release_memory_block(s_QuotaBlocks[0]); // refunds quotaHolder()
+        while (s_QuotaStep != 2) {
+            release_processor();
+        }
+
+        // leave reserveTaker() fewer blocks to take than its quota
+        while (g_AvailableCount > 2 * MEMORY_RESERVE && s_ExtraTaken < USER_BLOCK_QUOTA) {
+            s_ExtraBlocks[s_ExtraTaken] = request_memory_block();
+            s_ExtraTaken++;
+        }
+        s_Done++;
+
+        // lower priority, effectively inactivates this process
+        set_process_priority(PROCESS_2, LOWEST);
+    }
+}
+
+void reserveTaker(void) {
+    int i;
+
+    while (1) {
+        s_TimerLetter = request_memory_block();
+
+        // the last request waits until reserveChecker() releases a block
+        s_ReserveTaken = 0;
+        while (!s_ReserveChecked) {
+            s_ReserveBlocks[s_ReserveTaken] = request_memory_block();
+            s_ReserveTaken++;
+        }
+
+        for (i = 0; i < s_ReserveTaken; i++) {
+            release_memory_block(s_ReserveBlocks[i]);
+        }
+        for (i = 0; i < s_ExtraTaken; i++) {
+            release_memory_block(s_ExtraBlocks[i]);
+        }
+        for (i = 1; i <= USER_BLOCK_QUOTA; i++) {
+            release_memory_block(s_QuotaBlocks[i]);
+        }
+        s_Done++;
+
+        // lower priority, effectively inactivates this process
+        set_process_priority(PROCESS_3, LOWEST);
+    }
+}
+
+void reserveChecker(void) {
+    MemoryStats stats;
+
+    while (1) {
+        // runs once reserveTaker() waits; it is charged s_TimerLetter as well
+        if (s_ReserveTaken == 0 || g_AvailableCount != MEMORY_RESERVE
+                || get_memory_usage(PROCESS_3, NULL) != s_ReserveTaken + 1) {
+            s_Passed[3] = FAIL;
+        }
+
+        // the clock process sends its status report within the next second
+        delayed_send(PROCESS_4, s_TimerLetter, 1500);
+        s_TimerLetter = receive_message(NULL);
+        if (get_memory_stats(PROCESS_4, &stats) != RTX_OK
+                || stats.m_MinFreeBlocks >= MEMORY_RESERVE
+                || stats.m_MinFreeBlocks < IPROCESS_RESERVE) {
+            s_Passed[4] = FAIL;
+        }
+
+        // reserveTaker() is handed this block and finishes
+        s_ReserveChecked = 1;
+        release_memory_block(s_TimerLetter);
+        s_Done++;
+
+        // lower priority, effectively inactivates this process
+        set_process_priority(PROCESS_4, LOWEST);
+    }
+}
+
+void quotaResults(void) {
+    int completed = 0;
+    int i;
+
+    while (1) {
+        // print results once the other test processes have completed
+        if (!completed && s_Done == 4) {
+            for (i = 0; i < NUM_QUOTA_TESTS; i++) {
+                uart1_put_string(s_TestNames[i]);
+                if (s_Passed[i] == PASS) {
+                    uart1_put_string(": OK");
+                } else {
+                    uart1_put_string(": FAILED");
+                }
+                uart1_put_string("\r\n");
+            }
+
+            completed = 1;
+        }
+        release_processor();
+    }
+}
+
+void quotaDummy(void) {
+    while (1) {
+        release_processor();
+    }
+}
@@ -0,0 +1,44 @@
+/**
+ * @file:   QuotaTests.h
+ * @brief:  Unit tests for memory quotas and the reserved pools.
+ */
+
+#ifndef _QUOTA_TESTS_
+#define _QUOTA_TESTS_
+
+/*
+ * Sets test processes to quota tests.
+ */
+void set_test_procs(void);
+
+/*
+ * Process that waits on its own memory quota.
+ */
+void quotaHolder(void);
+
+/*
+ * Process that refunds quotaHolder(), then holds blocks for the reserve tests.
+ */
+void quotaRefunder(void);
+
+/*
+ * Process that takes every block a user process may take.
+ */
+void reserveTaker(void);
+
+/*
+ * Process that checks the reserved pools while reserveTaker() waits.
+ */
+void reserveChecker(void);
+
+/*
+ * Process to check and print test results.
+ */
+void quotaResults(void);
+
+/*
+ * Filler process (system must have 6 test processes).
+ */
+void quotaDummy(void);
+
+#endif /* _QUOTA_TESTS_ */
@@ -6,6 +6,7 @@
 #include "SetPriorityProcess.h"
 
 #include "rtx.h"
+#include "UART.h"
 #include "Utilities/String.h"
 
 #include <LPC17xx.h>
@@ -20,6 +21,120 @@
  */
 PROC_INIT g_SetPriorityProcess;
 
+/**
+ * Allocator telemetry at the last %M report, used to work out the allocation
+ * and release rates since then.
+ */
+static MemoryStats s_LastMemoryStats;
+
+/**
+ * Parses the decimal number starting at text[*index] and advances the index
+ * past it.
+ *
+ * @return  The number, or -1 if there is no digit at the index.
+ */
+static int parseDecimal(char text[], int* index) {
+    int value = -1;
+
+    while (text[*index] >= '0' && text[*index] <= '9' && value < NUM_PROCS) {
+        value = ((value < 0) ? 0 : value * 10) + (text[*index] - '0');
+        (*index)++;
+    }
+    return value;
+}
+
+/**
+ * Console report being written into packed letters. Text is appended to one
+ * letter until it is full, so that a report takes a block per
+ * MAX_PACKED_LETTER_LENGTH characters rather than a block per line; this
+ * process is PRIVILEGED, and would otherwise draw on the memory reserve.
+ */
+typedef struct Report {
+    Letter* m_Letter; // letter being filled
+    int m_Length; // length of its text
+} Report;
+
+/**
+ * Starts a report in the given letter (usually the command letter).
+ */
+static void beginReport(Report* report, Letter* message) {
+    report->m_Letter = message;
+    report->m_Letter->m_Type = DEFAULT;
+    report->m_Length = 0;
+}
+
+/**
+ * Appends text to a report. A full letter is sent to the CRT and the text
+ * continues in a new one.
+ */
+static void appendReport(Report* report, char text[]) {
+    int i;
+
+    for (i = 0; text[i] != '\0'; i++) {
+        if (report->m_Length == MAX_PACKED_LETTER_LENGTH - 1) {
+            report->m_Letter->m_Text[report->m_Length] = '\0';
+            send_message(CRT_PROCESS, (void*)report->m_Letter);
+            beginReport(report, (Letter*)request_memory_block());
+        }
+        report->m_Letter->m_Text[report->m_Length] = text[i];
+        report->m_Length++;
+    }
+}
+
+/**
+ * Appends a number in decimal to a report.
+ */
+static void appendDecimal(Report* report, U32 value) {
+    char digits[11];
+
+    strdecimal(value, digits);
+    appendReport(report, digits);
+}
+
+/**
+ * Appends a rate in events per second to a report.
+ */
+static void appendRate(Report* report, U32 count, U32 milliseconds) {
+    appendDecimal(report, (milliseconds == 0) ? 0 : count * 1000 / milliseconds);
+    appendReport(report, "/s");
+}
+
+/**
+ * Sends the last letter of a report to the CRT.
+ */
+static void endReport(Report* report) {
+    report->m_Letter->m_Text[report->m_Length] = '\0';
+    send_message(CRT_PROCESS, (void*)report->m_Letter);
+}
+
+/**
+ * Prints the stack high-water mark and stack size of every live process.
+ * Reuses the command letter.
+ */
+static void reportStackUsage(Letter* message) {
+    Report report;
+    int processID;
+    int used;
+    int size;
+
+    beginReport(&report, message);
+    appendReport(&report, "\r\nPID USED/SIZE\r\n");
+    for (processID = 0; processID < NUM_PROCS; processID++) {
+        used = get_stack_usage(processID, &size);
+        if (used == RTX_ERR) {
+            continue;
+        }
+
+        appendDecimal(&report, processID);
+        appendReport(&report, " ");
+        appendDecimal(&report, used);
+        appendReport(&report, "/");
+        appendDecimal(&report, size);
+        appendReport(&report, "\r\n");
+    }
+    endReport(&report);
+}
+
 void initializeSetPriorityProcess(void) {
     g_SetPriorityProcess.m_pid = (U32)PROCESS_SET_PRIORITY;
     g_SetPriorityProcess.m_priority = PRIVILEGED;
@@ -27,6 +142,100 @@ void initializeSetPriorityProcess(void) {
     g_SetPriorityProcess.mpf_start_pc = &runSetPriorityProcess;
 }
 
+/**
+ * Prints the memory blocks held by every live process, the blocks charged to
+ * it against its quota and the total and longest time it waited for memory
+ * (ms), then the free block count and its low-water mark, the reserves
+ * (system/i-process), the requests that had to wait and the blocks handed
+ * straight to a waiter, the allocation and release rates since the last
+ * report, and the UART letters dropped for lack of memory or backlog. Reuses
+ * the command letter.
+ */
+static void reportMemoryUsage(Letter* message) {
+    Report report;
+    MemoryStats stats;
+    int processID;
+    int used;
+    int quota;
+
+    beginReport(&report, message);
+    appendReport(&report, "\r\nPID HELD USED/QUOTA WAIT/MAX\r\n");
+    for (processID = 0; processID < NUM_PROCS; processID++) {
+        used = get_memory_usage(processID, &quota);
+        if (used == RTX_ERR) {
+            continue;
+        }
+        get_memory_stats(processID, &stats);
+
+        appendDecimal(&report, processID);
+        appendReport(&report, " ");
+        appendDecimal(&report, get_owned_blocks(processID));
+        appendReport(&report, " ");
+        appendDecimal(&report, used);
+        appendReport(&report, "/");
+        appendDecimal(&report, quota);
+        appendReport(&report, " ");
+        appendDecimal(&report, stats.m_WaitTotal);
+        appendReport(&report, "/");
+        appendDecimal(&report, stats.m_WaitMax);
+        appendReport(&report, "\r\n");
+    }
+
+    get_memory_stats(PROCESS_SET_PRIORITY, &stats);
+    appendReport(&report, "FREE ");
+    appendDecimal(&report, stats.m_FreeBlocks);
+    appendReport(&report, " MIN ");
+    appendDecimal(&report, stats.m_MinFreeBlocks);
+    appendReport(&report, " RESERVE ");
+    appendDecimal(&report, MEMORY_RESERVE);
+    appendReport(&report, "/");
+    appendDecimal(&report, IPROCESS_RESERVE);
+    appendReport(&report, "\r\nBLOCKED ");
+    appendDecimal(&report, stats.m_BlockedEvents);
+    appendReport(&report, " HANDED ");
+    appendDecimal(&report, stats.m_HandOvers);
+    appendReport(&report, " ALLOC ");
+    appendRate(&report, stats.m_Requests - s_LastMemoryStats.m_Requests, stats.m_Uptime - s_LastMemoryStats.m_Uptime);
+    appendReport(&report, " FREED ");
+    appendRate(&report, stats.m_Releases - s_LastMemoryStats.m_Releases, stats.m_Uptime - s_LastMemoryStats.m_Uptime);
+    appendReport(&report, "\r\nDROPPED IN ");
+    appendDecimal(&report, getDroppedInputCount());
+    appendReport(&report, " OUT ");
+    appendDecimal(&report, getDroppedOutputCount());
+    appendReport(&report, "\r\n");
+    endReport(&report);
+    s_LastMemoryStats = stats;
+}
+
+/**
+ * Prints the LEAK_REPORT_LENGTH allocated blocks that have been with their
+ * owner the longest. Reuses the command letter.
+ */
+static void reportOldestBlocks(Letter* message) {
+    BlockInfo oldest[LEAK_REPORT_LENGTH];
+    Report report;
+    char digits[9];
+    int count;
+    int i;
+
+    // take the snapshot first so the report's own blocks are not in it
+    count = get_oldest_blocks(oldest, LEAK_REPORT_LENGTH);
+
+    beginReport(&report, message);
+    appendReport(&report, "\r\nBLOCK OWNER AGE(ms)\r\n");
+    for (i = 0; i < count; i++) {
+        strhex((U32)oldest[i].m_Block, digits);
+        appendReport(&report, "0x");
+        appendReport(&report, digits);
+        appendReport(&report, " ");
+        appendDecimal(&report, oldest[i].m_Owner);
+        appendReport(&report, " ");
+        appendDecimal(&report, oldest[i].m_Age);
+        appendReport(&report, "\r\n");
+    }
+    endReport(&report);
+}
+
 void runSetPriorityProcess(void) {
     Letter* message;
     
@@ -35,35 +244,72 @@ void runSetPriorityProcess(void) {
 // and doing so messes with the scheduling of the performance tests
 #ifndef DEBUG_PERFORMANCE
     Letter* registerCommand;
+
+    // the first %M report gives the rates since boot
+    s_LastMemoryStats.m_Requests = 0;
+    s_LastMemoryStats.m_Releases = 0;
+    s_LastMemoryStats.m_Uptime = 0;
     
     // register set priority commands to KCD
     registerCommand = (Letter*)request_memory_block();  
     registerCommand->m_Type = KCD_REG;
     strcpy("%C", registerCommand->m_Text);
     send_message(KCD_PROCESS, (void*)registerCommand);
+
+    registerCommand = (Letter*)request_memory_block();  
+    registerCommand->m_Type = KCD_REG;
+    strcpy("%S", registerCommand->m_Text);
+    send_message(KCD_PROCESS, (void*)registerCommand);
+
+    registerCommand = (Letter*)request_memory_block();  
+    registerCommand->m_Type = KCD_REG;
+    strcpy("%M", registerCommand->m_Text);
+    send_message(KCD_PROCESS, (void*)registerCommand);
+
+    registerCommand = (Letter*)request_memory_block();  
+    registerCommand->m_Type = KCD_REG;
+    strcpy("%L", registerCommand->m_Text);
+    send_message(KCD_PROCESS, (void*)registerCommand);
 #endif /* !DEBUG_PERFORMANCE */
     
     while (1) {
-        int commandLength;
-        int processID;
-        int newPriority;
+        int index = 3; // "%C <process ID> <priority>"
+        int processID = -1;
+        int newPriority = -1;
         int sender;
         
         message = (Letter*)receive_message(&sender);
-        commandLength = strlen(message->m_Text);
-        
-        if (commandLength == 6 && message->m_Text[4] == ' ') {
-            processID = message->m_Text[3] - '0';
-            newPriority = message->m_Text[5] - '0';
-            
-            if (processID < PROCESS_1 || processID > PROCESS_C) { // ensure process ID is between 1 to 9
-                strcpy("\r\nBad ID\r\n", message->m_Text);
+        if (message->m_Text[1] == 'S' || message->m_Text[1] == 'M' || message->m_Text[1] == 'L') {
+            if (message->m_Text[2] != '\0') {
+                message->m_Type = DEFAULT;
+                strcpy("\r\nBad Format\r\n", message->m_Text);
                 send_message(CRT_PROCESS, (void*)message);
-            } else if (newPriority < HIGH || newPriority > LOWEST) { // ensure new priority is between 1 to 4
+            } else if (message->m_Text[1] == 'S') {
+                reportStackUsage(message);
+            } else if (message->m_Text[1] == 'M') {
+                reportMemoryUsage(message);
+            } else {
+                reportOldestBlocks(message);
+            }
+            release_processor();
+            continue;
+        }
+        if (message->m_Text[2] == ' ') {
+            processID = parseDecimal(message->m_Text, &index);
+        }
+        if (processID >= 0 && message->m_Text[index] == ' ') {
+            index++;
+            newPriority = parseDecimal(message->m_Text, &index);
+        }
+        
+        if (newPriority >= 0 && message->m_Text[index] == '\0') {
+            if (newPriority < HIGH || newPriority > LOWEST) { // ensure new priority is a user priority
                 strcpy("\r\nBad Priority\r\n", message->m_Text);
                 send_message(CRT_PROCESS, (void*)message);
+            } else if (processID < PROCESS_1 || processID >= NUM_PROCS || set_process_priority(processID, newPriority) != RTX_OK) {
+                strcpy("\r\nBad ID\r\n", message->m_Text);
+                send_message(CRT_PROCESS, (void*)message);
             } else {
-                set_process_priority(processID, newPriority);
                 if (sender == KCD_PROCESS) {
                     strcpy("\r\n", message->m_Text);
                     send_message(CRT_PROCESS, (void*)message);
@@ -1,11 +1,17 @@
 /**
  * @file:   SetPriorityProcess.h
- * @brief:  Set priority process
+ * @brief:  Set priority process (%C), which also reports stack (%S) and
+ *          memory (%M) usage and the oldest allocated blocks (%L)
  */
  
 #ifndef _SET_PRIORITY_PROCESS_
 #define _SET_PRIORITY_PROCESS_
 
+/**
+ * Number of blocks listed by the %L (oldest blocks) report.
+ */
+#define LEAK_REPORT_LENGTH 5
+
 /**
  * Initializes the set priority process table item. Called during process
  * initialization.
@@ -14,7 +20,12 @@ void initializeSetPriorityProcess(void);
 
 /**
  * The set priority process. This is the function that is run when the set
- * priority process is scheduled.
+ * priority process is scheduled. "%C <process ID> <priority>" changes a
+ * process' priority; "%S" prints each process' stack high-water mark and
+ * stack size in bytes; "%M" prints the memory blocks each process holds, the
+ * blocks charged to it against its quota and its waits for memory, then the
+ * allocator telemetry; "%L" lists the blocks that have
+ * been with their owner the longest, to find leaks.
  */
 void runSetPriorityProcess(void);
 
@@ -109,8 +109,9 @@ void stressTestC(void) {
             delayedMessage = (Letter*)request_memory_block();
             delayedMessage->m_Type = WAKEUP;
             
-            // delay for 10 seconds
-            delayed_send(PROCESS_C, (void*)delayedMessage, 10000);
+            // delay for 10 seconds; the exact wake-up time doesn't matter,
+            // so let the timer coalesce it with other wake-ups
+            delayed_send_slack(PROCESS_C, (void*)delayedMessage, 10000, 100);
             
             while (1) {
                 receivedMessage = (Letter*)receive_message(NULL);
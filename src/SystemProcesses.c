@@ -14,6 +14,10 @@
 #include "printf.h"
 #endif /* DEBUG_0 */
 
+#if defined(DEBUG_0) || defined(DEBUG_PERFORMANCE)
+#include "DebugLog.h"
+#endif /* DEBUG_0 || DEBUG_PERFORMANCE */
+
 
 /**
  * CRT process initialization table item. Initialized with values on an
@@ -40,9 +44,15 @@ PROC_INIT g_NullProcess;
 static int s_BufferIndex;
 
 /**
- * KCD command table. The command table can hold up to 10 commands.
+ * KCD command registry. Each bucket is a list of the commands that hash to it.
  */
-static Command s_CommandTable[COMMAND_TABLE_SIZE];
+static Command* s_CommandTable[COMMAND_HASH_SIZE];
+
+/**
+ * Unused command entries. Entries are carved out of memory blocks as the
+ * registry grows and are recycled when commands are unregistered.
+ */
+static Command* s_FreeCommands;
 
 /**
  * KCD buffer to hold input until it is sent to a process (or cleared). The
@@ -50,16 +60,150 @@ static Command s_CommandTable[COMMAND_TABLE_SIZE];
  */
 static char s_InputBuffer[MAX_LETTER_LENGTH];
 
-void addCommand(char text[], int registerPID) {
+/**
+ * Characters to echo back to the CRT for the input burst being processed.
+ */
+static char s_EchoBuffer[MAX_LETTER_LENGTH];
+
+/**
+ * Number of characters in s_EchoBuffer.
+ */
+static int s_EchoLength;
+
+/**
+ * Text currently drawn in each CRT status region, padded with spaces.
+ */
+static char s_StatusRegions[NUM_STATUS_REGIONS][STATUS_REGION_WIDTH];
+
+/**
+ * Gets a letter for the KCD to send: the spare letter if there is one (the
+ * received input letter, once its text has been copied out), or a new block.
+ */
+static Letter* takeLetter(Letter** spare) {
+    Letter* letter = *spare;
+
+    if (letter == NULL) {
+        letter = (Letter*)request_memory_block();
+    }
+    *spare = NULL;
+    letter->m_Type = DEFAULT;
+    return letter;
+}
+
+/**
+ * Sends the pending echo characters to the CRT, if there are any.
+ */
+static void flushEcho(Letter** spare) {
+    Letter* letter;
+
+    if (s_EchoLength > 0) {
+        letter = takeLetter(spare);
+        s_EchoBuffer[s_EchoLength] = '\0';
+        strcpy(s_EchoBuffer, letter->m_Text);
+        send_message(CRT_PROCESS, (void*)letter);
+        s_EchoLength = 0;
+    }
+}
+
+/**
+ * Queues characters to be echoed to the CRT, flushing first if they don't fit.
+ */
+static void echo(char text[], Letter** spare) {
+    int n = strlen(text);
     int i;
 
-    for (i = 0; i < COMMAND_TABLE_SIZE; i++) {
-        if (s_CommandTable[i].commandPID == -1) {
-            s_CommandTable[i].commandPID = registerPID;
-            strcpy(text, s_CommandTable[i].commandText);
-            break;
+    if (s_EchoLength + n > MAX_LETTER_LENGTH - 1) {
+        flushEcho(spare);
+    }
+    for (i = 0; i < n; i++) {
+        s_EchoBuffer[s_EchoLength] = text[i];
+        s_EchoLength++;
+    }
+}
+
+/**
+ * Gets the length of the command name at the start of text (up to the first
+ * space or the end of the string).
+ */
+static int commandLength(char text[]) {
+    int n = 0;
+
+    while (text[n] != '\0' && text[n] != ' ') {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Gets the registry bucket of the command name at the start of text.
+ */
+static Command** findBucket(char text[]) {
+    U32 hash = 5381;
+    int i;
+
+    for (i = 0; text[i] != '\0' && text[i] != ' '; i++) {
+        hash = hash * 33 + (U8)text[i];
+    }
+    return &s_CommandTable[hash % COMMAND_HASH_SIZE];
+}
+
+/**
+ * Finds the registered command whose name matches the command name at the
+ * start of text.
+ */
+static Command* findCommand(char text[]) {
+    int n = commandLength(text);
+    Command* command = *findBucket(text);
+    int j;
+
+    while (command != NULL) {
+        for (j = 0; j < n && command->commandText[j] == text[j]; j++) {
+        }
+        if (j == n && command->commandText[n] == '\0') {
+            return command;
+        }
+        command = command->m_Next;
+    }
+    return NULL;
+}
+
+int addCommand(char text[], int registerPID) {
+    int n = strlen(text);
+    Command* command;
+    Command** bucket;
+
+    // command can't have size of 1 because there should be a character after
+    // '%', and the name can't contain spaces
+    if (n <= 1 || n > MAX_COMMAND_LENGTH || text[0] != '%' || commandLength(text) != n) {
+        return RTX_ERR;
+    }
+
+    command = findCommand(text);
+    if (command != NULL) {
+        return (command->commandPID == registerPID) ? RTX_OK : RTX_ERR;
+    }
+
+    if (s_FreeCommands == NULL) {
+        // grow the registry by one memory block's worth of entries
+        Command* block = (Command*)request_memory_block();
+        int i;
+
+        for (i = 0; i < BLOCK_SIZE / sizeof(Command); i++) {
+            block[i].m_Next = s_FreeCommands;
+            s_FreeCommands = &block[i];
         }
     }
+
+    command = s_FreeCommands;
+    s_FreeCommands = command->m_Next;
+
+    command->commandPID = registerPID;
+    strcpy(text, command->commandText);
+
+    bucket = findBucket(text);
+    command->m_Next = *bucket;
+    *bucket = command;
+    return RTX_OK;
 }
 
 void clearBuffer(void) {
@@ -80,21 +224,12 @@ void deleteFromBuffer(void) {
 }
 
 int getCommandProcess(char buffer[]) {
-    int i;
-    int j;
+    Command* command;
 
     if (buffer[0] == '%') {
-        for (i = 0; s_CommandTable[i].commandPID != -1 && i < COMMAND_TABLE_SIZE; i++) {
-            for (j = 0; s_CommandTable[i].commandText[j] != '\0' && buffer[j] != '\0'; j++) {
-                if (s_CommandTable[i].commandText[j] != buffer[j]) {
-                    j = -1;
-                    break;
-                }
-            }
-
-            if (j != -1) { // command must be valid
-                return s_CommandTable[i].commandPID;
-            }
+        command = findCommand(buffer);
+        if (command != NULL) {
+            return command->commandPID;
         }
     }
 
@@ -128,15 +263,217 @@ void initializeSystemProcesses() {
     initializeKCDProcess();
 }
 
+void removeProcessCommands(int registerPID) {
+    Command** link;
+    Command* command;
+    int i;
+
+    for (i = 0; i < COMMAND_HASH_SIZE; i++) {
+        link = &s_CommandTable[i];
+        while (*link != NULL) {
+            command = *link;
+            if (command->commandPID == registerPID) {
+                *link = command->m_Next;
+                command->m_Next = s_FreeCommands;
+                s_FreeCommands = command;
+            } else {
+                link = &(command->m_Next);
+            }
+        }
+    }
+}
+
+int removeCommand(char text[], int registerPID) {
+    Command** link = findBucket(text);
+    Command* command = findCommand(text);
+
+    if (command == NULL || command->commandPID != registerPID) {
+        return RTX_ERR;
+    }
+
+    while (*link != command) {
+        link = &((*link)->m_Next);
+    }
+    *link = command->m_Next;
+
+    command->m_Next = s_FreeCommands;
+    s_FreeCommands = command;
+    return RTX_OK;
+}
+
+/**
+ * Clears the screen and reserves the top row for the status regions by
+ * limiting scrolling to the rows below it.
+ */
+static void initializeStatusLine(void) {
+#ifndef DEBUG_PERFORMANCE
+    Letter* letter;
+#endif /* !DEBUG_PERFORMANCE */
+    int i;
+    int j;
+
+    for (i = 0; i < NUM_STATUS_REGIONS; i++) {
+        for (j = 0; j < STATUS_REGION_WIDTH; j++) {
+            s_StatusRegions[i][j] = ' ';
+        }
+    }
+
+// the UART doesn't advance its mailbox in performance testing mode
+#ifndef DEBUG_PERFORMANCE
+    // ESC[2J, ESC[2;<rows>r, ESC[<rows>;1H
+    letter = (Letter*)request_memory_block();
+    letter->m_Type = OUTPUT_INTERACTIVE;
+    strcpy("\033[2J\033[2;", letter->m_Text);
+    i = strlen(letter->m_Text);
+    i += strdecimal(TERMINAL_ROWS, &(letter->m_Text[i]));
+    strcpy("r\033[", &(letter->m_Text[i]));
+    i += 3;
+    i += strdecimal(TERMINAL_ROWS, &(letter->m_Text[i]));
+    strcpy(";1H", &(letter->m_Text[i]));
+    send_message(UART_IPROCESS, (void*)letter);
+    ((LPC_UART_TypeDef*)LPC_UART0)->IER = IER_THRE | IER_RLS | IER_RBR; // trigger interrupt
+#endif /* !DEBUG_PERFORMANCE */
+}
+
+/**
+ * Rewrites a STATUS_UPDATE letter in place into the escape sequence that
+ * redraws the changed span of its region, between saving and restoring the
+ * cursor. The text is emptied if nothing changed.
+ */
+static void renderStatus(Letter* letter) {
+    char text[STATUS_REGION_WIDTH];
+    int region = letter->m_Text[0] - '0';
+    int first = -1;
+    int last = -1;
+    int n;
+    int i;
+
+    if (region < 0 || region >= NUM_STATUS_REGIONS) {
+        letter->m_Text[0] = '\0';
+        return;
+    }
+
+    for (i = 0; i < STATUS_REGION_WIDTH && letter->m_Text[i + 1] != '\0'; i++) {
+        text[i] = letter->m_Text[i + 1];
+    }
+    for (; i < STATUS_REGION_WIDTH; i++) {
+        text[i] = ' ';
+    }
+
+    for (i = 0; i < STATUS_REGION_WIDTH; i++) {
+        if (text[i] != s_StatusRegions[region][i]) {
+            if (first == -1) {
+                first = i;
+            }
+            last = i;
+            s_StatusRegions[region][i] = text[i];
+        }
+    }
+
+    if (first == -1) {
+        letter->m_Text[0] = '\0';
+        return;
+    }
+
+    // ESC7, ESC[1;<column>H, changed span, ESC8
+    strcpy("\0337\033[1;", letter->m_Text);
+    n = strlen(letter->m_Text);
+    n += strdecimal(region * (STATUS_REGION_WIDTH + 1) + first + 1, &(letter->m_Text[n]));
+    letter->m_Text[n] = 'H';
+    n++;
+    for (i = first; i <= last; i++) {
+        letter->m_Text[n] = text[i];
+        n++;
+    }
+    strcpy("\0338", &(letter->m_Text[n]));
+}
+
+/**
+ * Gets the output class of a message from the specified sender.
+ */
+static int getOutputClass(int sender) {
+    int priority = get_process_priority(sender);
+
+    if (priority == PRIVILEGED) {
+        return OUTPUT_INTERACTIVE;
+    } else if (priority == HIGH || priority == MEDIUM) {
+        return OUTPUT_NORMAL;
+    }
+    return OUTPUT_BULK;
+}
+
+/**
+ * Packs a message into the packed letter of its output class. The first
+ * message of a class becomes its packed letter. When a packed letter fills
+ * up, it is forwarded to the UART and packing continues in place in the
+ * message's block (copying its text forward is safe since length <= i).
+ */
+static void packOutput(Letter** packed, int* length, Letter* message, int outputClass) {
+    int i;
+
+    if (*packed == NULL) {
+        *packed = message;
+        *length = strlen(message->m_Text);
+        return;
+    }
+
+    for (i = 0; message->m_Text[i] != '\0'; i++) {
+        if (*length == MAX_PACKED_LETTER_LENGTH - 1) {
+            (*packed)->m_Type = outputClass;
+            (*packed)->m_Text[*length] = '\0';
+            send_message(UART_IPROCESS, (void*)*packed);
+            *packed = message;
+            *length = 0;
+        }
+        (*packed)->m_Text[*length] = message->m_Text[i];
+        (*length)++;
+    }
+
+    if (message != *packed) {
+        release_memory_block((void*)message);
+    }
+}
+
 void runCRTProcess(void) {
     LPC_UART_TypeDef* pUart;
-    void* message;
+    Letter* packed[NUM_OUTPUT_CLASSES];
+    int length[NUM_OUTPUT_CLASSES];
+    Letter* message;
+    int sender;
+    int outputClass;
     pUart = (LPC_UART_TypeDef*) LPC_UART0;
+
+    initializeStatusLine();
     
     while (1) {
-        message = receive_message(NULL);
-        send_message(UART_IPROCESS, message); // forward message to UART
-        pUart->IER = IER_THRE | IER_RLS | IER_RBR; // trigger interrupt
+        // pack everything that is waiting into as few letters as possible,
+        // keeping each output class separate
+        for (outputClass = 0; outputClass < NUM_OUTPUT_CLASSES; outputClass++) {
+            packed[outputClass] = NULL;
+        }
+
+        message = (Letter*)receive_message(&sender);
+        do {
+            if (message->m_Type == STATUS_UPDATE) {
+                // status redraws are tiny and must never be dropped, or the
+                // drawn text would no longer match s_StatusRegions
+                renderStatus(message);
+                outputClass = OUTPUT_INTERACTIVE;
+            } else {
+                outputClass = getOutputClass(sender);
+            }
+            packOutput(&packed[outputClass], &length[outputClass], message, outputClass);
+        } while ((message = (Letter*)poll_message(&sender)) != NULL);
+
+        // forward the batch to the UART, most urgent class first
+        for (outputClass = 0; outputClass < NUM_OUTPUT_CLASSES; outputClass++) {
+            if (packed[outputClass] != NULL) {
+                packed[outputClass]->m_Type = outputClass;
+                packed[outputClass]->m_Text[length[outputClass]] = '\0';
+                send_message(UART_IPROCESS, (void*)packed[outputClass]);
+            }
+        }
+        pUart->IER = IER_THRE | IER_RLS | IER_RBR; // trigger interrupt once per batch
         release_processor();
     }
 }
@@ -149,54 +486,82 @@ void runKCDProcess(void) {
     // initialize input buffer
     clearBuffer();
     
-    // initialize command table
-    for (i = 0; i < COMMAND_TABLE_SIZE; i++) {
-        s_CommandTable[i].commandPID = -1;
+    // initialize command registry
+    for (i = 0; i < COMMAND_HASH_SIZE; i++) {
+        s_CommandTable[i] = NULL;
     }
+    s_FreeCommands = NULL;
     
     while(1) {
         message = (Letter*)receive_message(&sender);
 
         if (message->m_Type == DEFAULT && sender == UART_IPROCESS) { // message type is regular
-            if (message->m_Text[0] == '\r') { // return character: check for command, clear buffer
-                int process = getCommandProcess(s_InputBuffer);
-                if (process != -1) {
-                    // input is a command, send the command to the corresponding process
-                    strcpy(s_InputBuffer, message->m_Text);
-                    send_message(process, (void*)message);
-                } else {
-                    strcpy("\r\n", message->m_Text); // append newline
-                    send_message(CRT_PROCESS, (void*)message);
-                }
-                clearBuffer();
-            } else if (message->m_Text[0] == 0x7F) { // backspace
-                deleteFromBuffer();
-                send_message(CRT_PROCESS, (void*)message);
-            } else { // normal character
-                if (s_InputBuffer[MAX_LETTER_LENGTH - 2] == '\0') { // we use -2 because we need to leave room for the null character
-                    writeToBuffer(message->m_Text[0]);
-                    send_message(CRT_PROCESS, (void*)message);
-                } else {
+            // the UART packs a whole RX FIFO burst into one letter
+            char input[MAX_LETTER_LENGTH];
+            Letter* spare = message; // reused for the first letter we send
+            char character[2];
+
+            strcpy(message->m_Text, input);
+            character[1] = '\0';
+            s_EchoLength = 0;
+
+            for (i = 0; input[i] != '\0'; i++) {
+                character[0] = input[i];
+
+                if (input[i] == '\r') { // return character: check for command, clear buffer
+                    int process = getCommandProcess(s_InputBuffer);
+                    if (process != -1) {
+                        // input is a command, send the command to the corresponding process
+                        Letter* command;
+
+                        flushEcho(&spare);
+                        command = takeLetter(&spare);
+                        strcpy(s_InputBuffer, command->m_Text);
+                        if (send_message(process, (void*)command) != RTX_OK) {
+                            // the registered process has exited
+                            removeCommand(command->m_Text, process);
+                            release_memory_block((void*)command);
+                        }
+                    } else {
+                        echo("\r\n", &spare); // append newline
+                    }
+                    clearBuffer();
+                } else if (input[i] == 0x7F) { // backspace
+                    deleteFromBuffer();
+                    echo(character, &spare);
+                } else { // normal character
                     // if buffer is full, we do not print the character
-                    // so release memory block
-                    release_memory_block((void*)message);
+                    if (s_InputBuffer[MAX_LETTER_LENGTH - 2] == '\0') { // we use -2 because we need to leave room for the null character
+                        writeToBuffer(input[i]);
+                        echo(character, &spare);
+                    }
                 }
             }
-        } else if (message->m_Type == KCD_REG) { // register command
-            int n = strlen(message->m_Text);
-
-            // command can't have size of 1
-            // because there should be a character after '%'
-            if (n > 1 && n <= MAX_COMMAND_LENGTH && message->m_Text[0] == '%' && message->m_Text[1] != ' ') {
-                message->m_Text[n] = ' '; // add an extra space at the end of the command 
-                message->m_Text[n + 1] = '\0';
 
-                // if command doesn't already exist, register it
-                if (getCommandProcess(message->m_Text) == -1) {
-                    addCommand(message->m_Text, sender);
+            flushEcho(&spare);
+            if (spare != NULL) {
+                release_memory_block((void*)spare); // nothing was sent in it
+            }
+        } else if (message->m_Type == INPUT_LINE && sender == UART_IPROCESS) { // completed line, already echoed by the UART
+            int process = getCommandProcess(message->m_Text);
+
+            message->m_Type = DEFAULT;
+            if (process != -1) {
+                // input is a command, send the command to the corresponding process
+                if (send_message(process, (void*)message) != RTX_OK) {
+                    // the registered process has exited
+                    removeCommand(message->m_Text, process);
+                    release_memory_block((void*)message);
                 }
+            } else {
+                strcpy("\r\n", message->m_Text); // append newline
+                send_message(CRT_PROCESS, (void*)message);
             }
-
+        } else if (message->m_Type == KCD_REG) { // register command
+            addCommand(message->m_Text, sender);
+            release_memory_block((void*)message);
+        } else if (message->m_Type == KCD_UNREG) { // unregister command
+            removeCommand(message->m_Text, sender);
             release_memory_block((void*)message);
         }
         release_processor();
@@ -205,6 +570,9 @@ void runKCDProcess(void) {
 
 void runNullProcess() {
     while(1) {
+#if defined(DEBUG_0) || defined(DEBUG_PERFORMANCE)
+        flushDebugLog(); // drain buffered debug output while idle
+#endif /* DEBUG_0 || DEBUG_PERFORMANCE */
         release_processor();
     }
 }
@@ -10,20 +10,25 @@
 #include "Utilities/Types.h"
 
 /**
- * Command structure for storing commands and their associated process.
+ * Command structure for storing commands and their associated process. These
+ * act as the nodes of a command registry hash bucket.
  */
 typedef struct Command {
+   struct Command* m_Next; // next command in the bucket (or in the free list)
    int commandPID;
-   char commandText[MAX_COMMAND_LENGTH + 2];
+   char commandText[MAX_COMMAND_LENGTH + 1];
 } Command;
 
 /**
- * Adds (registers) a command to the KCD's command table.
+ * Adds (registers) a command to the KCD's command registry. Registering a
+ * command again from the same process has no effect.
  * 
  * @param   text The command that the process wishes to register.
  * @param   registerPID The PID of the registering process.
+ * @return  RTX_OK if the command is registered to registerPID, RTX_ERR if the
+ *          command is invalid or registered to another process.
  */
-void addCommand(char text[], int registerPID);
+int addCommand(char text[], int registerPID);
 
 /**
  * Sets all characters of KCD's buffer to null.
@@ -36,14 +41,34 @@ void clearBuffer(void);
 void deleteFromBuffer(void);
 
 /**
- * Gets the process ID associated with the command contained in buffer.
+ * Gets the process ID associated with the command contained in buffer. The
+ * command name is the text up to the first space; lookup is hashed.
  * 
- * @param   buffer The specified command.
+ * @param   buffer The specified command, optionally followed by arguments.
  * @return  The process ID associated with the command if it exists, -1
  *          otherwise.
  */
 int getCommandProcess(char buffer[]);
 
+/**
+ * Removes (unregisters) a command from the KCD's command registry.
+ * 
+ * @param   text The command that the process wishes to unregister.
+ * @param   registerPID The PID of the process that registered the command.
+ * @return  RTX_OK if the command was removed, RTX_ERR if it is not registered
+ *          to registerPID.
+ */
+int removeCommand(char text[], int registerPID);
+
+/**
+ * Removes every command registered to a process from the KCD's command
+ * registry. Called when the process exits, so that a process reusing its PID
+ * does not inherit its commands.
+ * 
+ * @param   registerPID The PID of the exiting process.
+ */
+void removeProcessCommands(int registerPID);
+
 /**
  * Initializes the CRT process table item.
  */
@@ -67,7 +92,8 @@ void initializeSystemProcesses(void);
 
 /**
  * The CRT process. This is the function that is run when the CRT process is
- * scheduled.
+ * scheduled. STATUS_UPDATE letters are redrawn in place on the status line
+ * (the top terminal row); all other letters are printed.
  */
 void runCRTProcess(void);
 
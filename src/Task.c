@@ -0,0 +1,76 @@
+/**
+ * @file:   Task.c
+ * @brief:  Lightweight tasks dispatched by the task worker process
+ */
+
+#include "Task.h"
+
+#include "rtx.h"
+#include "Utilities/ProcessQueue.h"
+
+/**
+ * Task worker process initialization table item. Initialized with values on
+ * an initializeTaskWorker() call.
+ */
+PROC_INIT g_TaskWorker;
+
+/**
+ * Handlers of the created tasks; task ID NUM_PROCS + i runs s_Tasks[i].
+ */
+static TaskHandler s_Tasks[NUM_TASKS];
+static int s_TaskCount;
+
+/**
+ * ID of the task the worker is running, or TASK_WORKER between messages.
+ */
+static int s_RunningTask = TASK_WORKER;
+
+extern PCB* g_CurrentProcess;
+extern int startTaskWorker(void);
+
+int getRunningTask(void) {
+    return s_RunningTask;
+}
+
+void initializeTaskWorker(void) {
+    g_TaskWorker.m_pid = (U32)TASK_WORKER;
+    g_TaskWorker.m_priority = PRIVILEGED;
+    g_TaskWorker.m_stack_size = 0x200; // shared by every task handler
+    g_TaskWorker.mpf_start_pc = &runTaskWorker;
+}
+
+int isTask(int id) {
+    return id >= NUM_PROCS && id < NUM_PROCS + s_TaskCount;
+}
+
+int k_create_task(TaskHandler handler) {
+    // handlers run at PRIVILEGED with the worker's quota and reserve access,
+    // so only system processes may create them
+    if (handler == NULL || s_TaskCount >= NUM_TASKS || g_CurrentProcess->m_Priority != PRIVILEGED) {
+        return RTX_ERR;
+    }
+    if (startTaskWorker() != RTX_OK) {
+        return RTX_ERR;
+    }
+    s_Tasks[s_TaskCount] = handler;
+    s_TaskCount++;
+    return NUM_PROCS + s_TaskCount - 1;
+}
+
+void runTaskWorker(void) {
+    void* message;
+    int sender;
+
+    while (1) {
+        message = receive_message(&sender);
+
+        // the envelope still names the task the message was sent to
+        s_RunningTask = ((Envelope*)((U32)message - sizeof(Envelope)))->m_DestinationPID;
+        if (isTask(s_RunningTask)) {
+            s_Tasks[s_RunningTask - NUM_PROCS](message, sender);
+        } else {
+            release_memory_block(message); // not addressed to a task
+        }
+        s_RunningTask = TASK_WORKER;
+    }
+}
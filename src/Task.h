@@ -0,0 +1,75 @@
+/**
+ * @file:   Task.h
+ * @brief:  Lightweight tasks dispatched by the task worker process
+ */
+ 
+#ifndef _TASK_
+#define _TASK_
+
+#include "Utilities/Types.h"
+
+/**
+ * Lightweight task message handler. A task has no stack or PCB of its own:
+ * the task worker process receives messages addressed to the task ID and
+ * calls the handler on its own stack, once per message. The handler owns the
+ * message and must send or release it. It runs to completion; anything that
+ * blocks (receive_message(), or request_memory_block() with the pool empty)
+ * stalls every task until it returns.
+ */
+typedef void (*TaskHandler)(void* message, int sender_id);
+
+/**
+ * Stackless coroutine helpers for task handlers, in the style of
+ * protothreads. The state is an int kept by the handler (0 initially), for
+ * example a static. TASK_WAIT returns from the handler, and the next message
+ * resumes it after the TASK_WAIT. Locals do not survive a TASK_WAIT, and a
+ * handler may not use a switch statement around one.
+ */
+#define TASK_BEGIN(state) switch (state) { case 0:
+#define TASK_WAIT(state) do { (state) = __LINE__; return; case __LINE__:; } while (0)
+#define TASK_END(state) } (state) = 0
+
+/**
+ * Gets the task the task worker is running. Messages the worker sends come
+ * from this ID.
+ * 
+ * @return  The running task's ID, or TASK_WORKER between messages.
+ */
+int getRunningTask(void);
+
+/**
+ * Initializes the task worker process table item. Called during process
+ * initialization.
+ */
+void initializeTaskWorker(void);
+
+/**
+ * Checks whether an ID belongs to a created task.
+ * 
+ * @param   id The ID of interest.
+ * @return  1 if the ID is a task ID, 0 otherwise.
+ */
+int isTask(int id);
+
+/**
+ * Creates a lightweight task. Messages sent to the returned ID (with
+ * send_message() or delayed_send()) are passed to the handler by the task
+ * worker process, which runs at PRIVILEGED priority. Only PRIVILEGED (system)
+ * processes may create tasks, since handlers get the worker's priority,
+ * quota and access to the memory reserve. The first call starts the task
+ * worker, allocating its stack.
+ * 
+ * @param   handler The message handler of the task.
+ * @return  The task ID (NUM_PROCS and up), or RTX_ERR if all NUM_TASKS tasks
+ *          exist, the caller is not a system process or there is no room for
+ *          the worker's stack.
+ */
+int k_create_task(TaskHandler handler);
+
+/**
+ * The task worker process. This is the function that is run when the task
+ * worker process is scheduled.
+ */
+void runTaskWorker(void);
+
+#endif /* _TASK_ */
@@ -5,6 +5,8 @@
 
 #include "Timer.h"
 
+#include "k_critical.h"
+#include "k_memory.h"
 #include "k_process.h"
 #include "Utilities/Definitions.h"
 
@@ -26,6 +28,150 @@ PROC_INIT g_TimerProcess;
  */
 static MessageQueue s_CentralMailbox;
 
+/**
+ * Number of deferred timer passes that hit TIMER_DELIVERY_BUDGET while expired
+ * mail was still waiting.
+ */
+static U32 s_TimerOverruns;
+
+/**
+ * Number of ticks during which the null process was running.
+ */
+static U32 s_IdleTicks;
+
+/**
+ * Moves all envelopes waiting in the timer i-process mailbox into the central
+ * mailbox, sorted by expiry. The mailbox is lock-free and the central mailbox
+ * is private to the timer, so no interrupts are masked.
+ */
+static void collectTimerMail(void) {
+    void* newMessage;
+    Envelope* envelope;
+
+    newMessage = nonBlockingReceiveMessage(TIMER_IPROCESS, NULL);
+    while (newMessage != NULL) {
+        envelope = (Envelope*)((U32)newMessage - sizeof(Envelope)); // get address of envelope
+        insertEnvelope(&s_CentralMailbox, envelope);
+        newMessage = nonBlockingReceiveMessage(TIMER_IPROCESS, NULL);
+    }
+}
+
+/**
+ * Checks whether an envelope has reached its deadline (expiry plus slack) at
+ * the given time. Reaching a deadline triggers a delivery pass.
+ *
+ * @param   envelope The envelope of interest (may be NULL).
+ * @param   now The current time in milliseconds.
+ * @param   offset Microseconds elapsed since the start of the current tick.
+ * @return  1 if the envelope has expired, 0 otherwise.
+ */
+static int hasExpired(Envelope* envelope, U32 now, U32 offset) {
+    U32 deadline;
+
+    if (envelope == NULL) {
+        return 0;
+    }
+    deadline = envelope->m_Expiry + envelope->m_Slack;
+    return deadline < now || (deadline == now && (U32)envelope->m_ExpiryOffset <= offset);
+}
+
+/**
+ * Checks whether an envelope may be delivered at the given time, i.e. whether
+ * the start of its slack window has been reached.
+ *
+ * @param   envelope The envelope of interest.
+ * @param   now The current time in milliseconds.
+ * @param   offset Microseconds elapsed since the start of the current tick.
+ * @return  1 if the envelope may be delivered, 0 otherwise.
+ */
+static int isDeliverable(Envelope* envelope, U32 now, U32 offset) {
+    return (U32)envelope->m_Expiry < now
+            || ((U32)envelope->m_Expiry == now && (U32)envelope->m_ExpiryOffset <= offset);
+}
+
+/**
+ * Runs a delivery pass if the earliest deadline in the central mailbox has
+ * been reached. The pass also sends every other message whose slack window
+ * has opened, so loosely timed wake-ups are coalesced into one pass and one
+ * reschedule. At most the given number of messages are sent.
+ *
+ * @param   now The current time in milliseconds.
+ * @param   offset Microseconds elapsed since the start of the current tick.
+ * @param   budget The maximum number of messages to send.
+ * @return  The number of messages sent.
+ */
+static int deliverExpiredMail(U32 now, U32 offset, int budget) {
+    Envelope* previous = NULL;
+    Envelope* envelope = s_CentralMailbox.m_First;
+    int delivered = 0;
+    U32 criticalSection;
+
+    if (!hasExpired(envelope, now, offset)) {
+        return 0;
+    }
+
+    // the queue is sorted by deadline and slack is bounded, so nothing past
+    // now + MAX_TIMER_SLACK can have an open window
+    while (envelope != NULL && delivered < budget && (U32)(envelope->m_Expiry + envelope->m_Slack) <= now + MAX_TIMER_SLACK) {
+        if (isDeliverable(envelope, now, offset)) {
+            removeNextEnvelope(&s_CentralMailbox, previous);
+
+            // posting is lock-free, but waking the receiver touches the ready queue
+            criticalSection = enterCriticalSection();
+            if (nonPreemptiveSendMessage(envelope->m_SenderPID, envelope->m_DestinationPID, (void *)((U32)envelope + sizeof(Envelope))) != RTX_OK) {
+                nonPreemptiveReleaseMemory((void *)((U32)envelope + sizeof(Envelope))); // receiver has exited
+            }
+            exitCriticalSection(criticalSection);
+
+            delivered++;
+        } else {
+            previous = envelope;
+        }
+        envelope = (previous == NULL) ? s_CentralMailbox.m_First : previous->m_Next;
+    }
+    return delivered;
+}
+
+/**
+ * Programs match register 1 for the earliest pending expiry if it falls inside
+ * the current tick; otherwise disables the match 1 interrupt. Match register 0
+ * keeps driving the periodic tick.
+ *
+ * @return  1 if the earliest expiry is too close to program and should be
+ *          delivered immediately, 0 otherwise.
+ */
+static int armHighResolutionTimer(void) {
+    Envelope* first = s_CentralMailbox.m_First;
+
+    if (first != NULL && (U32)(first->m_Expiry + first->m_Slack) == g_timer_count && first->m_ExpiryOffset > 0) {
+        if ((U32)first->m_ExpiryOffset <= LPC_TIM0->TC + HIGH_RES_TIMER_MARGIN) {
+            return 1;
+        }
+        LPC_TIM0->MR1 = first->m_ExpiryOffset;
+        LPC_TIM0->MCR |= BIT(3); // interrupt on MR1
+    } else {
+        LPC_TIM0->MCR &= ~BIT(3);
+    }
+    return 0;
+}
+
+/**
+ * Reads the current time as a tick count and a microsecond offset into that
+ * tick. Accounts for a tick that has matched but not yet been serviced.
+ *
+ * @param   now The current time in milliseconds is written into this address.
+ * @param   offset The microseconds elapsed since the start of the current
+ *                 tick are written into this address.
+ */
+static void readTimer(U32* now, U32* offset) {
+    *now = g_timer_count;
+    *offset = LPC_TIM0->TC;
+    if (LPC_TIM0->IR & BIT(0)) { // TC has been reset, but the tick is still pending
+        *now += 1;
+        *offset = LPC_TIM0->TC;
+    }
+}
+
 /**
  * @brief: Initializes the timer. 
  */
@@ -76,14 +222,21 @@ uint32_t timer_init(uint8_t n_timer) {
 
     /* Step 4.1: Prescale Register PR setting 
        CCLK = 100 MHZ, PCLK = CCLK/4 = 25 MHZ
-       2*(12499 + 1)*(1/25) * 10^(-6) s = 10^(-3) s = 1 ms
+       Timer 0: (24 + 1)*(1/25) * 10^(-6) s = 1 us
+       TC (Timer Counter) counts microseconds within the current tick, so
+       MR1 can be used for sub-millisecond (high resolution) expiries
+       Timer 1: 2*(12499 + 1)*(1/25) * 10^(-6) s = 10^(-3) s = 1 ms
        TC (Timer Counter) toggles b/w 0 and 1 every 12500 PCLKs
        see MR setting below 
     */
-    pTimer->PR = 12499;  
-
     /* Step 4.2: MR setting, see section 21.6.7 on pg496 of LPC17xx_UM. */
-    pTimer->MR0 = 1;
+    if (n_timer == 0) {
+        pTimer->PR = 24;
+        pTimer->MR0 = TIMER_TICK_US - 1;
+    } else {
+        pTimer->PR = 12499;
+        pTimer->MR0 = 1;
+    }
 
     /* Step 4.3: MCR setting, see table 429 on pg496 of LPC17xx_UM.
        Interrupt on MR0: when MR0 mathches the value in the TC, 
@@ -94,10 +247,12 @@ uint32_t timer_init(uint8_t n_timer) {
 
     g_timer_count = 0;
 
-    /* Step 4.4: CSMSIS enable timer IRQ */
+    /* Step 4.4: CSMSIS set timer IRQ priority and enable timer IRQ */
     if (n_timer == 0) {
+        NVIC_SetPriority(TIMER0_IRQn, TIMER_IRQ_PRIORITY);
         NVIC_EnableIRQ(TIMER0_IRQn);
     } else if (n_timer == 1) {
+        NVIC_SetPriority(TIMER1_IRQn, PERFORMANCE_TIMER_IRQ_PRIORITY);
         NVIC_EnableIRQ(TIMER1_IRQn);
     }
 
@@ -107,8 +262,72 @@ uint32_t timer_init(uint8_t n_timer) {
     return 0;
 }
 
+void cancelTimerMail(int processID) {
+    Envelope* previous = NULL;
+    Envelope* envelope;
+
+    collectTimerMail();
+
+    envelope = s_CentralMailbox.m_First;
+    while (envelope != NULL) {
+        if (envelope->m_DestinationPID == processID) {
+            removeNextEnvelope(&s_CentralMailbox, previous);
+            nonPreemptiveReleaseMemory((void *)((U32)envelope + sizeof(Envelope)));
+        } else {
+            previous = envelope;
+        }
+        envelope = (previous == NULL) ? s_CentralMailbox.m_First : previous->m_Next;
+    }
+}
+
+U32 getIdleTickCount(void) {
+    return s_IdleTicks;
+}
+
+U32 getTimerOverrunCount(void) {
+    return s_TimerOverruns;
+}
+
+int hasPendingTimerMail(void) {
+    return !isEmptyMailbox(&(g_ProcessTable[TIMER_IPROCESS]->m_Mailbox))
+            || (s_CentralMailbox.m_First != NULL && (U32)(s_CentralMailbox.m_First->m_Expiry + s_CentralMailbox.m_First->m_Slack) <= g_timer_count);
+}
+
+int serviceTimerMail(int budget) {
+    U32 now;
+    U32 offset;
+    int delivered;
+
+    collectTimerMail();
+    readTimer(&now, &offset);
+    delivered = deliverExpiredMail(now, offset, budget);
+    while (delivered < budget && armHighResolutionTimer()) {
+        readTimer(&now, &offset);
+        delivered += deliverExpiredMail(now, offset + HIGH_RES_TIMER_MARGIN, budget - delivered);
+    }
+
+    // anything still expired waits for the next tick
+    if (delivered >= budget && hasExpired(s_CentralMailbox.m_First, now, offset)) {
+        s_TimerOverruns++;
+    }
+    return delivered > 0;
+}
+
+void setHighResolutionExpiry(Envelope* envelope, int delay) {
+    U32 now;
+    U32 offset;
+
+    readTimer(&now, &offset);
+    offset += delay;
+    envelope->m_Expiry = now + offset / TIMER_TICK_US;
+    envelope->m_ExpiryOffset = offset % TIMER_TICK_US;
+    envelope->m_Slack = 0;
+}
+
 void initializeTimerProcess() {
     initializeMessageQueue(&s_CentralMailbox);
+    s_TimerOverruns = 0;
+    s_IdleTicks = 0;
     g_TimerProcess.m_pid = (U32)TIMER_IPROCESS;
     g_TimerProcess.m_priority = NULL_PRIORITY;
     g_TimerProcess.m_stack_size = 0x100;
@@ -132,39 +351,29 @@ __asm void TIMER0_IRQHandler(void)
 } 
 /**
  * @brief: c TIMER0 IRQ Handler
+ * NOTE: The handler only bumps the time. Sorting and delivering delayed mail
+ *       is deferred to PendSV, which runs at the lowest priority and can be
+ *       preempted by the UART, so the work done here is constant. The timer
+ *       mailbox is lock-free, so no interrupts need to be masked.
  */
 void c_TIMER0_IRQHandler(void) {
-    void* newMessage;
-    Envelope* envelope;
-    
-    int flag = 0;
-    
-    __disable_irq();
+    uint32_t interrupts;
 
     // acknowledge interrupt, see section  21.6.1 on pg 493 of LPC17XX_UM
-    LPC_TIM0->IR = BIT(0);  
+    // MR0 is the periodic tick, MR1 is the high resolution one-shot
+    interrupts = LPC_TIM0->IR & (BIT(0) | BIT(1));
+    LPC_TIM0->IR = interrupts;
     
     // increment timer
-    g_timer_count++;
-    
-    // get current mail
-    newMessage = nonBlockingReceiveMessage(TIMER_IPROCESS, NULL);
-    while (newMessage != NULL) {
-        envelope = (Envelope*)((U32)newMessage - sizeof(Envelope)); // get address of envelope
-        insertEnvelope(&s_CentralMailbox, envelope);
-        newMessage = nonBlockingReceiveMessage(TIMER_IPROCESS, NULL);
+    if (interrupts & BIT(0)) {
+        g_timer_count++;
+        if (g_CurrentProcess != NULL && g_CurrentProcess->m_PID == NULL_PROCESS) {
+            s_IdleTicks++;
+        }
     }
-        
-    // send all expired mail
-    while (s_CentralMailbox.m_First != NULL && s_CentralMailbox.m_First->m_Expiry <= g_timer_count) {
-        flag = 1;
-        envelope = dequeueEnvelope(&s_CentralMailbox);
-        nonPreemptiveSendMessage(envelope->m_SenderPID, envelope->m_DestinationPID, (void *)((U32)envelope + sizeof(Envelope)));
-    }
-    
-    __enable_irq();
     
-    if (flag == 1) {
-        k_release_processor();
+    // hand sorting and delivery off to the deferred context
+    if ((interrupts & BIT(1)) || hasPendingTimerMail()) {
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
     }
 }
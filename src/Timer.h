@@ -6,8 +6,63 @@
 #ifndef _TIMER_H_
 #define _TIMER_H_
 
+#include "Utilities/Types.h"
+
 #include <stdint.h>
 
+/**
+ * Discards all delayed messages addressed to the specified process and
+ * releases their memory. Must be called with kernel interrupts masked.
+ * 
+ * @param   processID The ID of the receiving process.
+ */
+void cancelTimerMail(int processID);
+
+/**
+ * Gets the number of timer ticks during which the null process was running.
+ * 
+ * @return  The number of idle ticks since initialization.
+ */
+U32 getIdleTickCount(void);
+
+/**
+ * Gets the number of deferred timer passes that ran out of delivery budget
+ * while expired mail was still waiting.
+ * 
+ * @return  The number of overruns since initialization.
+ */
+U32 getTimerOverrunCount(void);
+
+/**
+ * Checks whether the deferred timer pass has any work to do. Constant time;
+ * called from the timer interrupt.
+ * 
+ * @return  1 if mail is waiting to be sorted or has expired, 0 otherwise.
+ */
+int hasPendingTimerMail(void);
+
+/**
+ * Sorts mail waiting in the timer i-process mailbox into the central mailbox,
+ * sends expired mail (up to the given budget), and programs the high
+ * resolution match register for the earliest expiry that falls inside the
+ * current tick. Runs in the deferred (PendSV) or kernel context; interrupts
+ * are only masked around individual queue operations.
+ * 
+ * @param   budget The maximum number of messages to send in this pass.
+ * @return  1 if at least one message was sent, 0 otherwise.
+ */
+int serviceTimerMail(int budget);
+
+/**
+ * Sets the expiry of an envelope to the given number of microseconds from
+ * now.
+ * 
+ * @param   envelope The envelope to modify.
+ * @param   delay The amount of time in microseconds to wait before sending the
+ *                message.
+ */
+void setHighResolutionExpiry(Envelope* envelope, int delay);
+
 /**
  * Initializes the timer i-process table item. Called during process
  * initialization.
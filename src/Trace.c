@@ -0,0 +1,36 @@
+/**
+ * @file:   Trace.c
+ * @brief:  Deferred binary trace log implementation
+ */
+
+#include "Trace.h"
+
+#include <LPC17xx.h>
+
+extern volatile uint32_t g_timer_count;
+
+/**
+ * The trace log. It is read from a memory dump by the host, never on target.
+ */
+TraceLog g_TraceLog;
+
+void initializeTrace(void) {
+    g_TraceLog.m_Count = 0;
+    g_TraceLog.m_Magic = TRACE_MAGIC;
+}
+
+void trace(TraceEvent event, U32 first, U32 second) {
+    TraceRecord* record;
+    U32 index;
+
+    // claim a slot; an exception between LDREX and STREX makes the store fail
+    do {
+        index = __LDREXW((volatile U32*)&g_TraceLog.m_Count);
+    } while (__STREXW(index + 1, (volatile U32*)&g_TraceLog.m_Count) != 0);
+
+    record = &g_TraceLog.m_Records[index & (TRACE_LOG_SIZE - 1)];
+    record->m_Time = g_timer_count;
+    record->m_Args[0] = first;
+    record->m_Args[1] = second;
+    record->m_Header = ((U32)event << 16) | (LPC_TIM0->TC & 0xFFFF);
+}
@@ -0,0 +1,78 @@
+/**
+ * @file:   Trace.h
+ * @brief:  Deferred binary trace log
+ */
+
+#ifndef _TRACE_
+#define _TRACE_
+
+#include "Utilities/Types.h"
+
+/**
+ * Trace events. Each entry pairs an event ID with the format string used to
+ * print its two arguments. Only the ID is stored on the target; the host
+ * decoder (tools/decode_trace.py) reads this list to format the records, so
+ * entries may only be appended.
+ */
+#define TRACE_EVENTS \
+    TRACE_EVENT(TRACE_SWITCH,        "switch %u -> %u") \
+    TRACE_EVENT(TRACE_SEND,          "send %u -> %u") \
+    TRACE_EVENT(TRACE_DELAYED_SEND,  "delayed send to %u in %u ms") \
+    TRACE_EVENT(TRACE_RECEIVE,       "receive by %u from %u") \
+    TRACE_EVENT(TRACE_MEM_REQUEST,   "request by %u: block 0x%08x") \
+    TRACE_EVENT(TRACE_MEM_RELEASE,   "release by %u: block 0x%08x") \
+    TRACE_EVENT(TRACE_MEM_BLOCKED,   "%u blocked on memory at priority %u") \
+    TRACE_EVENT(TRACE_CREATE,        "created %u at priority %u") \
+    TRACE_EVENT(TRACE_EXIT,          "%u exited") \
+    TRACE_EVENT(TRACE_STACK_OVERFLOW, "%u overflowed its stack at 0x%08x") \
+    TRACE_EVENT(TRACE_MEM_QUOTA,     "%u blocked on its quota of %u blocks") \
+    TRACE_EVENT(TRACE_RESTART,       "%u restarted with %u blocks reclaimed")
+
+typedef enum {
+#define TRACE_EVENT(id, format) id,
+    TRACE_EVENTS
+#undef TRACE_EVENT
+    NUM_TRACE_EVENTS
+} TraceEvent;
+
+/**
+ * Trace record. Records are written in full by each trace() call.
+ */
+typedef struct TraceRecord {
+    U32 m_Header; // event ID in bits 31:16, microseconds into the tick in bits 15:0
+    U32 m_Time; // timer tick (ms) of the event
+    U32 m_Args[2]; // raw argument words
+} TraceRecord;
+
+/**
+ * Trace log. The host locates it in a memory dump by m_Magic. m_Count is the
+ * total number of records ever claimed, so the newest record is at
+ * (m_Count - 1) % TRACE_LOG_SIZE and older records are overwritten.
+ */
+typedef struct TraceLog {
+    U32 m_Magic; // TRACE_MAGIC once initialized
+    volatile U32 m_Count;
+    TraceRecord m_Records[TRACE_LOG_SIZE];
+} TraceLog;
+
+/**
+ * Value of TraceLog::m_Magic ("TRCE" in a little-endian dump).
+ */
+#define TRACE_MAGIC 0x45435254
+
+/**
+ * Initializes the trace log. Called first during kernel initialization.
+ */
+void initializeTrace(void);
+
+/**
+ * Records a trace event. Safe to call from processes, the kernel and interrupt
+ * handlers; slots are claimed with LDREX/STREX, so no interrupts are masked.
+ * 
+ * @param   event The event to record.
+ * @param   first The first argument word.
+ * @param   second The second argument word.
+ */
+void trace(TraceEvent event, U32 first, U32 second);
+
+#endif /* _TRACE_ */
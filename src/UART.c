@@ -7,9 +7,11 @@
 
 #include "UART.h"
 
+#include "k_critical.h"
 #include "k_memory.h"
 #include "k_process.h"
 #include "Polling/uart_polling.h"
+#include "Utilities/MessageQueue.h"
 #include "Utilities/String.h"
 
 #include <LPC17xx.h>
@@ -18,17 +20,473 @@
 #include "printf.h"
 #endif /* ! DEBUG_0 */
 
+#if defined(DEBUG_0) || defined(DEBUG_PERFORMANCE)
+#include "DebugLog.h"
+#endif /* DEBUG_0 || DEBUG_PERFORMANCE */
+
 /**
  * UART i-process initialization table item. Initialized with values on an
  * initializeUARTProcess() call.
  */
 PROC_INIT g_UARTProcess;
 
+/**
+ * Transmit ring buffer between the CRT's letters and the TX FIFO. The ring is
+ * empty when s_TxHead == s_TxTail and holds at most UART_TX_BUFFER_SIZE - 1
+ * characters.
+ */
+static char s_TxBuffer[UART_TX_BUFFER_SIZE];
+
+/**
+ * Index of the ring position into which the next character is copied.
+ */
+static int s_TxHead;
+
+/**
+ * Index of the next character to write to the TX FIFO.
+ */
+static int s_TxTail;
+
+/**
+ * Letter that is partially copied into the ring (the ring filled up before
+ * its end was reached), or NULL.
+ */
+static Letter* s_TxLetter;
+
+/**
+ * Index of the next character of s_TxLetter to copy into the ring.
+ */
+static int s_TxLetterIndex;
+
+/**
+ * Letters waiting for the transmit ring, one queue per output class.
+ */
+static MessageQueue s_TxQueues[NUM_OUTPUT_CLASSES];
+
+/**
+ * Number of letters in the OUTPUT_BULK queue.
+ */
+static int s_BulkOutputCount;
+
+/**
+ * Number of bulk output letters dropped because of backlog.
+ */
+static U32 s_DroppedOutputCount;
+
+/**
+ * Number of input letters dropped because no memory was available.
+ */
+static U32 s_DroppedInputCount;
+
+#ifdef _LINE_DISCIPLINE
+/**
+ * Characters echoed by the line discipline and not yet copied into the
+ * transmit ring. Echo is held back to a letter boundary, so that it never
+ * lands in the middle of a letter (such as a status line escape sequence).
+ */
+static char s_EchoBuffer[MAX_LETTER_LENGTH];
+static int s_EchoLength;
+static int s_EchoIndex;
+
+/**
+ * Copies pending echo into the transmit ring.
+ *
+ * @return  1 if all of it was copied, 0 if the ring filled up first.
+ */
+static int copyEcho(void) {
+    while (s_EchoIndex < s_EchoLength && (s_TxHead + 1) % UART_TX_BUFFER_SIZE != s_TxTail) {
+        s_TxBuffer[s_TxHead] = s_EchoBuffer[s_EchoIndex];
+        s_TxHead = (s_TxHead + 1) % UART_TX_BUFFER_SIZE;
+        s_EchoIndex++;
+    }
+    if (s_EchoIndex < s_EchoLength) {
+        return 0;
+    }
+    s_EchoLength = 0;
+    s_EchoIndex = 0;
+    return 1;
+}
+#endif /* _LINE_DISCIPLINE */
+
+/**
+ * Moves the letters in the UART i-process mailbox into the queue of their
+ * output class. If the bulk queue grows past MAX_BULK_OUTPUT letters, its
+ * oldest letter is dropped.
+ */
+static void queueOutput(void) {
+    Letter* letter;
+    int outputClass;
+    U32 criticalSection;
+
+    while ((letter = (Letter*)nonBlockingReceiveMessage(UART_IPROCESS, NULL)) != NULL) {
+        outputClass = letter->m_Type;
+        if (outputClass < 0 || outputClass >= NUM_OUTPUT_CLASSES) {
+            outputClass = OUTPUT_NORMAL;
+        }
+        enqueueLetter(&s_TxQueues[outputClass], letter);
+
+        if (outputClass == OUTPUT_BULK) {
+            s_BulkOutputCount++;
+            if (s_BulkOutputCount > MAX_BULK_OUTPUT) {
+                criticalSection = enterCriticalSection();
+                nonPreemptiveReleaseMemory((void*)dequeueLetter(&s_TxQueues[OUTPUT_BULK]));
+                exitCriticalSection(criticalSection);
+                s_BulkOutputCount--;
+                s_DroppedOutputCount++;
+            }
+        }
+    }
+}
+
+/**
+ * Takes the next letter to transmit from the most urgent non-empty output
+ * queue.
+ *
+ * @return  The letter, or NULL if all queues are empty.
+ */
+static Letter* takeOutput(void) {
+    Letter* letter;
+    int outputClass;
+
+    for (outputClass = 0; outputClass < NUM_OUTPUT_CLASSES; outputClass++) {
+        letter = dequeueLetter(&s_TxQueues[outputClass]);
+        if (letter != NULL) {
+            if (outputClass == OUTPUT_BULK) {
+                s_BulkOutputCount--;
+            }
+            return letter;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Copies queued letters into the transmit ring, most urgent output class
+ * first, until the ring is full or all output queues are empty. Pending echo
+ * goes in ahead of each letter. A letter's memory block is released as soon
+ * as its last character has been copied.
+ */
+static void fillTransmitBuffer(void) {
+    U32 criticalSection;
+
+    queueOutput();
+
+    while (1) {
+        if (s_TxLetter == NULL) {
+#ifdef _LINE_DISCIPLINE
+            if (!copyEcho()) {
+                return; // ring is full
+            }
+#endif /* _LINE_DISCIPLINE */
+            s_TxLetter = takeOutput();
+            s_TxLetterIndex = 0;
+            if (s_TxLetter == NULL) {
+                return; // nothing left to copy
+            }
+        }
+
+        while (s_TxLetter->m_Text[s_TxLetterIndex] != '\0' && (s_TxHead + 1) % UART_TX_BUFFER_SIZE != s_TxTail) {
+            s_TxBuffer[s_TxHead] = s_TxLetter->m_Text[s_TxLetterIndex];
+            s_TxHead = (s_TxHead + 1) % UART_TX_BUFFER_SIZE;
+            s_TxLetterIndex++;
+        }
+
+        if (s_TxLetter->m_Text[s_TxLetterIndex] != '\0') {
+            return; // ring is full; finish this letter on a later interrupt
+        }
+
+        criticalSection = enterCriticalSection();
+        nonPreemptiveReleaseMemory((void*)s_TxLetter); // release message's memory
+        exitCriticalSection(criticalSection);
+        s_TxLetter = NULL;
+    }
+}
+
+/**
+ * Writes up to UART_FIFO_SIZE characters from the transmit ring to the TX
+ * FIFO.
+ *
+ * @return  The number of characters written.
+ */
+static int drainTransmitBuffer(LPC_UART_TypeDef* pUart) {
+    int count = 0;
+
+    while (count < UART_FIFO_SIZE && s_TxTail != s_TxHead) {
+        pUart->THR = s_TxBuffer[s_TxTail]; // print character
+        s_TxTail = (s_TxTail + 1) % UART_TX_BUFFER_SIZE;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Sends a string to the KCD in a single letter. The string is dropped (and
+ * counted) if no memory is available, which the i-process reserve keeps to
+ * bursts that outrun the KCD.
+ *
+ * @param   text The null-terminated string to send.
+ * @param   type The message type of the letter.
+ */
+static void sendToKCD(char text[], int type) {
+    void* node;
+    Letter* newLetter;
+    U32 criticalSection;
+
+    criticalSection = enterCriticalSection();
+    node = nonBlockingRequestMemory(UART_IPROCESS); // request memory for message
+    exitCriticalSection(criticalSection);
+    if (node != NULL) {
+        newLetter = (Letter*)node;
+        newLetter->m_Type = type;
+        strcpy(text, newLetter->m_Text);
+
+        // send the letter
+        criticalSection = enterCriticalSection();
+        nonPreemptiveSendMessage(UART_IPROCESS, KCD_PROCESS, (void*)newLetter);
+        exitCriticalSection(criticalSection);
+    } else {
+        s_DroppedInputCount++;
+    }
+}
+
+#ifdef _LINE_DISCIPLINE
+/**
+ * Line being edited under the line discipline.
+ */
+static char s_LineBuffer[MAX_LETTER_LENGTH];
+
+/**
+ * Number of characters in s_LineBuffer.
+ */
+static int s_LineLength;
+
+/**
+ * Queues a character for echo and makes sure the transmitter is running. It
+ * goes into the transmit ring now if no letter is part way through being
+ * copied, or else once that letter is done. Echo is dropped if the echo
+ * buffer is full.
+ */
+static void echoCharacter(LPC_UART_TypeDef* pUart, char character) {
+    if (s_EchoLength < MAX_LETTER_LENGTH) {
+        s_EchoBuffer[s_EchoLength] = character;
+        s_EchoLength++;
+    }
+    if (s_TxLetter == NULL) {
+        fillTransmitBuffer();
+    }
+
+    if (!(pUart->IER & IER_THRE)) {
+        pUart->IER |= IER_THRE;
+        if (pUart->LSR & LSR_THRE) {
+            drainTransmitBuffer(pUart); // THRE fires again once this drains
+        }
+    }
+}
+
+/**
+ * Canonical line discipline. Edits and echoes input locally; only completed
+ * lines are delivered to the KCD, as one INPUT_LINE letter (without the
+ * carriage return). The KCD prints the newline for lines that are not
+ * commands, as it does for character input.
+ */
+static void handleLineInput(LPC_UART_TypeDef* pUart, char character) {
+    if (character == '\r') { // return character: deliver the line
+        s_LineBuffer[s_LineLength] = '\0';
+        sendToKCD(s_LineBuffer, INPUT_LINE);
+        s_LineLength = 0;
+    } else if (character == 0x7F) { // backspace
+        if (s_LineLength > 0) {
+            s_LineLength--;
+            echoCharacter(pUart, character);
+        }
+    } else if (s_LineLength < MAX_LETTER_LENGTH - 2) { // same limit as the KCD buffer
+        s_LineBuffer[s_LineLength] = character;
+        s_LineLength++;
+        echoCharacter(pUart, character);
+    }
+}
+#endif /* _LINE_DISCIPLINE */
+
+#ifdef _BINARY_CHANNEL
+/**
+ * Binary channel framing. Frames are multiplexed with console input on UART0:
+ * a frame is a COBS-encoded payload followed by a big-endian CRC-16/CCITT
+ * (polynomial 0x1021, initial value 0xFFFF), delimited by 0x00 bytes on both
+ * sides. Typed characters are never 0x00, so a 0x00 switches the receiver
+ * from console input to frame decoding until the closing delimiter.
+ */
+
+/**
+ * Whether the receiver is between frame delimiters.
+ */
+static int s_InFrame;
+
+/**
+ * Whether the rest of an over-long frame is being skipped. The receiver stays
+ * in the frame until its closing delimiter, then goes back to console input.
+ */
+static int s_SkippingFrame;
+
+/**
+ * Frame being decoded, or NULL if the current frame is being discarded.
+ */
+static Frame* s_Frame;
+
+/**
+ * Number of decoded bytes in s_Frame (payload and CRC).
+ */
+static int s_FrameLength;
+
+/**
+ * COBS state: the code byte of the current group, and the number of data
+ * bytes of the group still to come (0 when a code byte is expected).
+ */
+static int s_CobsCode;
+static int s_CobsRemaining;
+
+/**
+ * Running CRC of the decoded bytes. Including the transmitted CRC leaves 0.
+ */
+static U32 s_FrameCRC;
+
+/**
+ * Number of encoded (non-delimiter) bytes received in the current frame.
+ */
+static int s_EncodedLength;
+
+/**
+ * Process registered to receive frames, or -1.
+ */
+static int s_FrameReceiver;
+
+/**
+ * Number of dropped frames.
+ */
+static U32 s_FrameErrors;
+
+/**
+ * Starts decoding a new frame into a fresh memory block. The frame is
+ * discarded if no memory is available.
+ */
+static void beginFrame(void) {
+    U32 criticalSection;
+
+    if (s_Frame == NULL) {
+        criticalSection = enterCriticalSection();
+        s_Frame = (Frame*)nonBlockingRequestMemory(UART_IPROCESS);
+        exitCriticalSection(criticalSection);
+    }
+    s_FrameLength = 0;
+    s_EncodedLength = 0;
+    s_CobsCode = 0;
+    s_CobsRemaining = 0;
+    s_FrameCRC = 0xFFFF;
+}
+
+/**
+ * Appends a decoded byte to the frame and updates the CRC.
+ */
+static void appendFrameByte(U8 byte) {
+    int bit;
+
+    if (s_FrameLength == MAX_FRAME_LENGTH) {
+        s_FrameLength++; // too long; rejected when the frame ends
+        return;
+    } else if (s_FrameLength > MAX_FRAME_LENGTH) {
+        return;
+    }
+
+    s_Frame->m_Payload[s_FrameLength] = byte;
+    s_FrameLength++;
+
+    s_FrameCRC ^= (U32)byte << 8;
+    for (bit = 0; bit < 8; bit++) {
+        s_FrameCRC = (s_FrameCRC & 0x8000) ? ((s_FrameCRC << 1) ^ 0x1021) : (s_FrameCRC << 1);
+    }
+    s_FrameCRC &= 0xFFFF;
+}
+
+/**
+ * Finishes the current frame at its closing delimiter. A complete frame with
+ * a valid CRC is sent to the registered receiver; anything else is counted
+ * and its block kept for the next frame.
+ */
+static void endFrame(void) {
+    U32 criticalSection;
+
+    if (s_Frame == NULL || s_CobsRemaining != 0 || s_FrameLength < 2
+            || s_FrameLength > MAX_FRAME_LENGTH || s_FrameCRC != 0 || s_FrameReceiver == -1) {
+        s_FrameErrors++;
+        return;
+    }
+
+    s_Frame->m_Type = BINARY_FRAME;
+    s_Frame->m_Length = s_FrameLength - 2; // strip the CRC
+
+    criticalSection = enterCriticalSection();
+    if (nonPreemptiveSendMessage(UART_IPROCESS, s_FrameReceiver, (void*)s_Frame) == RTX_OK) {
+        s_Frame = NULL;
+    } else {
+        s_FrameErrors++; // the block is kept for the next frame
+    }
+    exitCriticalSection(criticalSection);
+}
+
+/**
+ * Feeds a received byte to the frame decoder. A frame that runs past the
+ * longest possible encoding is dropped: the rest of it is skipped, and its
+ * closing delimiter returns the receiver to console input.
+ */
+static void receiveFrameByte(U8 byte) {
+    if (s_SkippingFrame) {
+        if (byte == 0x00) {
+            s_SkippingFrame = 0;
+            s_InFrame = 0;
+        }
+        return;
+    }
+
+    if (byte == 0x00) { // delimiter
+        if (s_InFrame && s_EncodedLength > 0) {
+            endFrame();
+            s_InFrame = 0;
+        } else {
+            s_InFrame = 1; // opening delimiter (repeated delimiters are idle fill)
+            beginFrame();
+        }
+        return;
+    }
+
+    s_EncodedLength++;
+    if (s_EncodedLength > MAX_FRAME_LENGTH + MAX_FRAME_LENGTH / 254 + 1) {
+        s_FrameErrors++;
+        s_SkippingFrame = 1; // s_Frame is kept for the next frame
+        return;
+    }
+
+    if (s_Frame == NULL) {
+        return; // discarding this frame
+    }
+
+    if (s_CobsRemaining == 0) { // code byte
+        // every group but the last (and those of maximal length) ends in a zero
+        if (s_CobsCode != 0 && s_CobsCode != 0xFF) {
+            appendFrameByte(0x00);
+        }
+        s_CobsCode = byte;
+        s_CobsRemaining = byte - 1;
+    } else {
+        appendFrameByte(byte);
+        s_CobsRemaining--;
+    }
+}
+#endif /* _BINARY_CHANNEL */
+
 #ifdef _DEBUG_HOTKEYS
 /**
  * Reserved space for printing hotkey debug information.
  */
-static char s_DebugInfo[100];
+static char s_DebugInfo[DEBUG_INFO_SIZE];
 
 /**
  * Hotkey characters.
@@ -122,10 +580,11 @@ int uart_irq_init(int n_uart) {
            see table 278 on pg305 in LPC17xx_UM
     -----------------------------------------------------
         enable Rx and Tx FIFOs, clear Rx and Tx FIFOs
-    Trigger level 0 (1 char per interrupt)
+    Trigger level UART_RX_TRIGGER chars per interrupt; bytes below the trigger
+    level are picked up by the character timeout interrupt (CTI)
     */
     
-    pUart->FCR = 0x07;
+    pUart->FCR = UART_FCR_VALUE;
 
     /* Step 5 was done between step 2 and step 4 a few lines above */
 
@@ -149,8 +608,10 @@ int uart_irq_init(int n_uart) {
     /* Step 6b: enable the UART interrupt from the system level */
     
     if (n_uart == 0) {
+        NVIC_SetPriority(UART0_IRQn, UART_IRQ_PRIORITY); /* CMSIS function */
         NVIC_EnableIRQ(UART0_IRQn); /* CMSIS function */
     } else if (n_uart == 1) {
+        NVIC_SetPriority(UART1_IRQn, UART_IRQ_PRIORITY); /* CMSIS function */
         NVIC_EnableIRQ(UART1_IRQn); /* CMSIS function */
     } else {
         return 1; /* not supported yet */
@@ -215,7 +676,65 @@ int uart_polling_init(int n_uart) {
   return 0;
 }
 
+U32 getDroppedInputCount(void) {
+    return s_DroppedInputCount;
+}
+
+U32 getDroppedOutputCount(void) {
+    return s_DroppedOutputCount;
+}
+
+U32 getFrameErrorCount(void) {
+#ifdef _BINARY_CHANNEL
+    return s_FrameErrors;
+#else
+    return 0;
+#endif /* _BINARY_CHANNEL */
+}
+
+void removeFrameReceiver(int processID) {
+#ifdef _BINARY_CHANNEL
+    if (s_FrameReceiver == processID) {
+        s_FrameReceiver = -1;
+    }
+#endif /* _BINARY_CHANNEL */
+}
+
+int k_register_frame_receiver(void) {
+#ifdef _BINARY_CHANNEL
+    s_FrameReceiver = g_CurrentProcess->m_PID;
+    return RTX_OK;
+#else
+    return RTX_ERR;
+#endif /* _BINARY_CHANNEL */
+}
+
 void initializeUARTProcess() {
+    int i;
+
+    s_TxHead = 0;
+    s_TxTail = 0;
+    s_TxLetter = NULL;
+    s_TxLetterIndex = 0;
+    for (i = 0; i < NUM_OUTPUT_CLASSES; i++) {
+        initializeMessageQueue(&s_TxQueues[i]);
+    }
+    s_BulkOutputCount = 0;
+    s_DroppedOutputCount = 0;
+    s_DroppedInputCount = 0;
+#ifdef _LINE_DISCIPLINE
+    s_LineLength = 0;
+    s_EchoLength = 0;
+    s_EchoIndex = 0;
+#endif /* _LINE_DISCIPLINE */
+#ifdef _BINARY_CHANNEL
+    s_InFrame = 0;
+    s_SkippingFrame = 0;
+    s_Frame = NULL;
+    s_FrameReceiver = -1;
+    s_FrameErrors = 0;
+#endif /* _BINARY_CHANNEL */
+
     g_UARTProcess.m_pid = (U32)UART_IPROCESS;
     g_UARTProcess.m_priority = NULL_PRIORITY;
     g_UARTProcess.m_stack_size = 0x100;
@@ -245,72 +764,73 @@ void c_UART0_IRQHandler(void)
     uint8_t IIR_IntId; // interrupt ID from IIR          
     LPC_UART_TypeDef *pUart;
     
-    __disable_irq();
+    // mailboxes are lock-free; interrupts are only masked around the heap
+    // and ready queue updates below
     pUart = (LPC_UART_TypeDef *)LPC_UART0;
     
 #ifdef DEBUG_0
-    uart1_put_string("Entering c_UART0_IRQHandler\n\r");
+    printf("Entering c_UART0_IRQHandler\n\r");
 #endif // DEBUG_0
     // reading IIR automatically acknowledges the interrupt
-    IIR_IntId = (pUart->IIR) >> 1 ; // skip pending bit in IIR 
+    IIR_IntId = ((pUart->IIR) >> 1) & 0x07; // skip pending bit in IIR 
     
-    if (IIR_IntId & IIR_RDA) { // receive data available
-        void* node;
-        Letter* newLetter;
+    if (IIR_IntId == IIR_RDA || IIR_IntId == IIR_CTI) { // receive data available or character timeout
+        char burst[MAX_LETTER_LENGTH];
+        int length = 0;
         uint8_t character;
         
-        // read UART
-        // reading RBR will clear the interrupt
-        character = pUart->RBR;
+        // drain the RX FIFO into a single burst
+        // reading RBR until the FIFO is empty clears the interrupt
+        while ((pUart->LSR & LSR_RDR) && length < MAX_LETTER_LENGTH - 1) {
+            character = pUart->RBR;
+#ifdef _BINARY_CHANNEL
+            if (character == 0x00 || s_InFrame) {
+                receiveFrameByte(character);
+                continue;
+            }
+#endif /* _BINARY_CHANNEL */
 #ifdef DEBUG_0
-        uart1_put_string("Reading a char = ");
-        uart1_put_char(character);
-        uart1_put_string("\n\r");
+            printf("Reading a char = %c\n\r", character);
 #endif // DEBUG_0
         
 #ifdef _DEBUG_HOTKEYS
-        // check for hotkey
-        if (strcont(s_Hotkeys, character)) { // placeholder for hotkeys
-            hotkeyHandler(character);
-        } else {
-#endif // DEBUG_HOTKEYS
-            // send a message to KCD containing the character
-            node = nonBlockingRequestMemory(); // request memory for message
-            if (node != NULL) {
-                newLetter = (Letter*)node;
-                newLetter->m_Type = DEFAULT;
-                newLetter->m_Text[0] = character;
-                newLetter->m_Text[1] = '\0';
-                
-                // send the letter
-                nonPreemptiveSendMessage(UART_IPROCESS, KCD_PROCESS, (void*)newLetter);
+            // check for hotkey
+            if (strcont(s_Hotkeys, character)) { // placeholder for hotkeys
+                hotkeyHandler(character);
+                continue;
             }
-#ifdef _DEBUG_HOTKEYS   
-        }
 #endif // DEBUG_HOTKEYS
-    } else if (IIR_IntId & IIR_THRE) { // transmission
-        Letter* newLetter;
+#ifdef _LINE_DISCIPLINE
+            handleLineInput(pUart, character);
+#else
+            burst[length] = character;
+            length++;
+#endif /* _LINE_DISCIPLINE */
+        }
         
-        // THRE interrupt, transmit holding register becomes empty
-        newLetter = (Letter*)nonBlockingReceiveMessage(UART_IPROCESS, NULL);
-        while (newLetter != NULL) {
-            int i;
-            for (i = 0; newLetter->m_Text[i] != '\0'; i++) {
-                pUart->THR = newLetter->m_Text[i]; // print character
-            }       
-            nonPreemptiveReleaseMemory((void*)newLetter); // release message's memory
-            newLetter = (Letter*)nonBlockingReceiveMessage(UART_IPROCESS, NULL);
+        if (length > 0) {
+            // send one message to KCD containing the whole burst
+            burst[length] = '\0';
+            sendToKCD(burst, DEFAULT);
+        }
+    } else if (IIR_IntId == IIR_RLS) { // receive line status
+        // reading LSR clears the interrupt; the error is otherwise ignored
+        (void)pUart->LSR;
+    } else if (IIR_IntId == IIR_THRE) { // transmission
+        // THRE interrupt, the TX FIFO is empty
+        // top up the ring, then refill the FIFO with at most 16 characters
+        fillTransmitBuffer();
+        if (drainTransmitBuffer(pUart) == 0) {
+            // nothing left to send; the CRT re-enables THRE when it has output
+            pUart->IER &= ~IER_THRE;
         }
-        pUart->IER ^= IER_THRE; // toggle IER_THRE bit
-        pUart->THR = '\0';
     } else {
 #ifdef DEBUG_0
-            uart1_put_string("Should not get here!\n\r");
+            printf("Should not get here!\n\r");
 #endif // DEBUG_0
     }
     
-    __enable_irq();
-    k_release_processor();
+    releaseProcessorFromInterrupt();
 }
 
 #ifdef _DEBUG_HOTKEYS
@@ -377,9 +897,17 @@ void hotkeyHandler(char hotkey) {
             serializeBlockedOnReceive(s_DebugInfo, j);
         }
         
+        // UART1 is interrupt driven in debug builds, so share its buffer
         for (i=0; s_DebugInfo[i] != '\0'; i++) {
+#if defined(DEBUG_0) || defined(DEBUG_PERFORMANCE)
+            logPutc(NULL, s_DebugInfo[i]);
+#else
             uart1_put_char(s_DebugInfo[i]);
+#endif /* DEBUG_0 || DEBUG_PERFORMANCE */
         }
+#if defined(DEBUG_0) || defined(DEBUG_PERFORMANCE)
+        flushDebugLog();
+#endif /* DEBUG_0 || DEBUG_PERFORMANCE */
     }
 }
 
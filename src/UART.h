@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 #include "Utilities/Definitions.h"
+#include "Utilities/Types.h"
 
 #define uart0_irq_init() uart_irq_init(0)
 #define uart1_irq_init() uart_irq_init(1)
@@ -16,6 +17,48 @@
 #define uart0_polling_init() uart_polling_init(0)
 #define uart1_polling_init() uart_polling_init(1)
 
+/**
+ * Gets the number of input letters (characters, or lines under the line
+ * discipline) dropped because no memory block was available.
+ * 
+ * @return  The number of dropped letters since initialization.
+ */
+U32 getDroppedInputCount(void);
+
+/**
+ * Gets the number of bulk output letters dropped because the UART output
+ * backlog exceeded MAX_BULK_OUTPUT letters.
+ * 
+ * @return  The number of dropped letters since initialization.
+ */
+U32 getDroppedOutputCount(void);
+
+/**
+ * Gets the number of binary channel frames dropped because they were
+ * malformed, failed the CRC check, or could not be delivered.
+ * 
+ * @return  The number of dropped frames since initialization.
+ */
+U32 getFrameErrorCount(void);
+
+/**
+ * Registers the calling process to receive the frames of the UART binary
+ * channel, replacing any previous receiver. Each valid frame is delivered as
+ * one BINARY_FRAME message (see Frame).
+ * 
+ * @return  RTX_OK, or RTX_ERR if the binary channel is not compiled in.
+ */
+int k_register_frame_receiver(void);
+
+/**
+ * Stops delivering binary channel frames to a process, if it is the
+ * registered receiver. Called when the process exits, so that a process
+ * reusing its PID does not inherit its frames.
+ * 
+ * @param   processID The ID of the exiting process.
+ */
+void removeFrameReceiver(int processID);
+
 /**
  * Initializes the UART i-process table item. Called during process
  * initialization.
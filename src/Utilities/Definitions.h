@@ -13,19 +13,34 @@
 // memory management
 #define BLOCK_SIZE 128 // bytes
 #define NUM_BLOCKS 40
+#define MEMORY_RESERVE 8 // free blocks only PRIVILEGED processes and i-processes may take
+#define IPROCESS_RESERVE 4 // the last of the MEMORY_RESERVE blocks, for i-processes only
+#define USER_BLOCK_QUOTA 16 // default limit on blocks charged to a user process
+#define MEMORY_LOW_WATERMARK 12 // default free block count at which MEM_LOW is sent
+#define MEMORY_HIGH_WATERMARK 20 // default free block count at which MEM_OK is sent
+#define PRESSURE_LETTERS 4 // blocks outside the heap for MEM_LOW and MEM_OK letters
 #define RAM_END_ADDR 0x10008000
 
 // process management
 #define INITIAL_xPSR 0x01000000 // user process initial xPSR value
-#define NUM_PRIORITIES 6
-
-#define NUM_PROCS 16
+#ifndef NUM_PRIORITIES
+#define NUM_PRIORITIES 6 // at most 32; the scheduler keeps one bitmap bit per level
+#endif /* NUM_PRIORITIES */
+
+#define NUM_BOOT_PROCS 17 // processes created at initialization, with fixed PIDs
+#ifndef NUM_PROCS
+#define NUM_PROCS 24 // process table size (at most 256); PIDs from NUM_BOOT_PROCS up are created on demand
+#endif /* NUM_PROCS */
+#define MIN_STACK_SIZE 0x80 // bytes; smallest stack create_process() accepts
+#define STACK_PAINT 0xA5A5A5A5 // stack words that were never written hold this value
+#define STACK_GUARD_WORDS 2 // lowest stack words checked on every switch under _STACK_CHECK
 #define NUM_TEST_PROCS 6
 #define NUM_STRESS_PROCS 3
 #define NUM_IPROCS 2
 #define NUM_SYSTEM_PROCS 3
 
 #define NULL 0
+#define NO_OWNER -1 // owner of a free memory block
 
 // process IDs
 #define NULL_PROCESS            0
@@ -44,6 +59,10 @@
 #define CRT_PROCESS             13
 #define TIMER_IPROCESS          14
 #define UART_IPROCESS           15
+#define TASK_WORKER             16 // started by the first create_task()
+
+// lightweight tasks get IDs from NUM_PROCS up, after the process IDs
+#define NUM_TASKS 32
 
 // process priority
 // the higher the number, the lower the priority
@@ -51,18 +70,62 @@
 #define HIGH             1
 #define MEDIUM           2
 #define LOW              3
-#define LOWEST           4
-#define NULL_PRIORITY    5
+#define LOWEST           (NUM_PRIORITIES - 2) // user priorities are HIGH to LOWEST
+#define NULL_PRIORITY    (NUM_PRIORITIES - 1)
+
+#if NUM_PRIORITIES < 6 || NUM_PRIORITIES > 32
+#error "NUM_PRIORITIES must be between 6 and 32"
+#endif
+#if NUM_PROCS < NUM_BOOT_PROCS || NUM_PROCS > 256
+#error "NUM_PROCS must be between NUM_BOOT_PROCS and 256"
+#endif
 
 // IPC
 #define DEFAULT 0
 #define KCD_REG 1
 #define REPORT 2
 #define WAKEUP 3
+#define INPUT_LINE 4 // completed console line from the UART line discipline
+#define KCD_UNREG 5
+#define STATUS_UPDATE 6 // new text for a CRT status region; m_Text[0] is '0' + region
+#define BINARY_FRAME 7 // payload received on the UART binary channel (see Frame)
+#define MEM_LOW 8 // free memory fell to the low watermark; m_Text is the free block count
+#define MEM_OK 9 // free memory is back up to the high watermark; m_Text as MEM_LOW
+
+// console status line (top terminal row, kept out of the scrolling region)
+#define NUM_STATUS_REGIONS 3
+#define STATUS_CLOCK 0
+#define STATUS_CPU_LOAD 1
+#define STATUS_MEMORY 2
+#define STATUS_REGION_WIDTH 12 // characters per region
+#define TERMINAL_ROWS 24
+
+// console output classes, in transmission order (the CRT tags each letter it
+// forwards to the UART with the class of its senders)
+#define NUM_OUTPUT_CLASSES 3
+#define OUTPUT_INTERACTIVE 0 // privileged senders (echo, command replies, clock)
+#define OUTPUT_NORMAL 1 // high and medium priority senders
+#define OUTPUT_BULK 2 // everyone else; oldest letters are dropped under backlog
+#define MAX_BULK_OUTPUT 4 // letters of bulk output the UART holds before dropping
+
+// interrupt priorities (the lower the number, the more urgent)
+#define PERFORMANCE_TIMER_IRQ_PRIORITY 0 // above the kernel ceiling, never masked by the kernel
+#define KERNEL_IRQ_PRIORITY 1 // kernel ceiling; critical sections mask this level and below
+#define TIMER_IRQ_PRIORITY 1
+#define UART_IRQ_PRIORITY 2
+
+// timer
+#define TIMER_TICK_US 1000 // microseconds per timer tick
+#define HIGH_RES_TIMER_MARGIN 2 // microseconds; closer expiries are delivered immediately
+#define TIMER_DELIVERY_BUDGET 4 // max expired messages delivered per deferred timer pass
+#define MAX_TIMER_SLACK 1000 // ms; upper bound on the slack of a delayed send
+
+// tracing
+#define TRACE_LOG_SIZE 64 // records in the trace log; must be a power of two
 
 #define MAX_LETTER_LENGTH 35
-#define COMMAND_TABLE_SIZE 10
-#define MAX_COMMAND_LENGTH 3
+#define COMMAND_HASH_SIZE 16 // buckets in the KCD command registry
+#define MAX_COMMAND_LENGTH 16 // including the leading '%'
 
 #ifdef DEBUG_0
 #define USR_SZ_STACK 0x200 // user proc stack size 512B
@@ -82,7 +145,9 @@ typedef enum {
     RUNNING,
     BLOCKED_MEM, // queued state
     BLOCKED_IO,
-    BLOCKED_RECEIVE
+    BLOCKED_RECEIVE,
+    BLOCKED_QUOTA, // waiting for a block charged to the process to be released
+    EXITED // PCB is free (the process exited or was never created)
 } ProcessState;
 
 // UART flags
@@ -107,6 +172,15 @@ typedef enum {
 
 #define BUFSIZE     0x40
 
+#define UART_FIFO_SIZE      16 // bytes in the hardware TX FIFO
+#define UART_RX_TRIGGER     8 // RX FIFO trigger level in bytes: 1, 4, 8 or 14
+
+// FCR value: enable and reset both FIFOs, RX trigger level in bits 7:6
+#define UART_FCR_VALUE (0x07 | ((UART_RX_TRIGGER >= 14) ? 0xC0 : (UART_RX_TRIGGER >= 8) ? 0x80 : (UART_RX_TRIGGER >= 4) ? 0x40 : 0x00))
+#define UART_TX_BUFFER_SIZE 256 // bytes in the software TX ring buffer
+#define DEBUG_LOG_SIZE      1024 // bytes in the UART1 debug output ring buffer
+#define DEBUG_INFO_SIZE     (26 + NUM_PRIORITIES * 7 + NUM_PROCS * 10) // hotkey dump: header, "Pnn: \r\n" per level, "(ppp,nn)\r\n" per process
+
 // convenient macro for bit operation
 #define BIT(X) (1 << X)
 
@@ -0,0 +1,74 @@
+/**
+ * @file:   Mailbox.c
+ * @brief:  Multi-producer single-consumer mailbox implementation
+ */
+
+#include "Mailbox.h"
+
+#include <LPC17xx.h>
+
+/**
+ * Atomically detaches the incoming stack from the mailbox. Any exception taken
+ * between LDREX and STREX clears the exclusive monitor, so the store fails and
+ * the exchange is retried.
+ */
+static Envelope* detachIncoming(Mailbox* mailbox) {
+    Envelope* incoming;
+
+    do {
+        incoming = (Envelope*)__LDREXW((volatile U32*)&mailbox->m_Incoming);
+    } while (__STREXW((U32)NULL, (volatile U32*)&mailbox->m_Incoming) != 0);
+
+    return incoming;
+}
+
+void initializeMailbox(Mailbox* mailbox) {
+    mailbox->m_Incoming = NULL;
+    mailbox->m_First = NULL;
+}
+
+int isEmptyMailbox(Mailbox* mailbox) {
+    return mailbox->m_First == NULL && mailbox->m_Incoming == NULL;
+}
+
+int postEnvelope(Mailbox* mailbox, Envelope* envelope) {
+#ifdef DEBUG_PERFORMANCE
+    // performance tests send the same block repeatedly; linking it twice
+    // would make the list circular
+    if (envelope == mailbox->m_Incoming || envelope == mailbox->m_First) {
+        return RTX_OK;
+    }
+#endif /* DEBUG_PERFORMANCE */
+
+    do {
+        envelope->m_Next = (Envelope*)__LDREXW((volatile U32*)&mailbox->m_Incoming);
+    } while (__STREXW((U32)envelope, (volatile U32*)&mailbox->m_Incoming) != 0);
+
+    return RTX_OK;
+}
+
+Envelope* takeEnvelope(Mailbox* mailbox) {
+    Envelope* front;
+
+    if (mailbox->m_First == NULL) {
+        // reverse the incoming stack so the oldest envelope comes first
+        Envelope* incoming = detachIncoming(mailbox);
+        while (incoming != NULL) {
+            Envelope* next = incoming->m_Next;
+            incoming->m_Next = mailbox->m_First;
+            mailbox->m_First = incoming;
+            incoming = next;
+        }
+    }
+
+    front = mailbox->m_First; // this will be NULL if the mailbox is empty
+    if (front != NULL) {
+// during performance testing mode, always return the same message
+#ifndef DEBUG_PERFORMANCE
+        mailbox->m_First = front->m_Next;
+        front->m_Next = NULL;
+#endif /* DEBUG_PERFORMANCE */
+    }
+
+    return front;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file:   Mailbox.h
+ * @brief:  Multi-producer single-consumer mailbox for process IPC
+ */
+
+#ifndef _MAILBOX_
+#define _MAILBOX_
+
+#include "Types.h"
+
+/**
+ * Mailbox structure for process IPC. Producers (processes through the kernel,
+ * and interrupt handlers) push onto m_Incoming with LDREX/STREX, so posting
+ * never needs interrupts disabled. The single consumer (the owning process or
+ * i-process) detaches the whole incoming stack at once and reverses it into
+ * m_First, which only it touches.
+ */
+typedef struct Mailbox {
+    Envelope* volatile m_Incoming; // envelopes posted since the last take, newest first
+    Envelope* m_First; // envelopes ready to be taken, oldest first
+} Mailbox;
+
+/**
+ * Initializes the mailbox.
+ * 
+ * @param   mailbox The mailbox to operate on.
+ */
+void initializeMailbox(Mailbox* mailbox);
+
+/**
+ * Checks whether the mailbox is empty.
+ * 
+ * @param   mailbox The mailbox to operate on.
+ * @return  1 if the mailbox is empty, 0 otherwise.
+ */
+int isEmptyMailbox(Mailbox* mailbox);
+
+/**
+ * Adds the specified Envelope to the mailbox. Safe to call from any context,
+ * including interrupt handlers, concurrently with other producers.
+ * 
+ * @param   mailbox The mailbox to operate on.
+ * @param   envelope The Envelope to add.
+ * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
+ */
+int postEnvelope(Mailbox* mailbox, Envelope* envelope);
+
+/**
+ * Removes the oldest Envelope of the mailbox. Must only be called by the
+ * mailbox's single consumer.
+ * 
+ * @param   mailbox The mailbox to operate on.
+ * @return  The oldest Envelope of the mailbox, or NULL if the mailbox is empty.
+ */
+Envelope* takeEnvelope(Mailbox* mailbox);
+
+#endif /* _MAILBOX_ */
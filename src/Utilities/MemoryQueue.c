@@ -48,6 +48,8 @@ Node* dequeueNode(MemoryQueue* queue) {
 int enqueueNode(MemoryQueue* queue, Node* node) {
     // node will be the last element in the queue
     node->m_Next = NULL;
+    node->m_Owner = NO_OWNER;
+    node->m_ChargedTo = NO_OWNER;
 
     if (queue->m_First == NULL) {
         queue->m_First = node;
@@ -65,6 +67,24 @@ int enqueueNode(MemoryQueue* queue, Node* node) {
     return 1;
 }
 
+int pushNode(MemoryQueue* queue, Node* node) {
+    // node will be the first element in the queue
+    node->m_Next = queue->m_First;
+    node->m_Owner = NO_OWNER;
+    node->m_ChargedTo = NO_OWNER;
+
+    if (queue->m_First == NULL) {
+        queue->m_Last = node;
+    }
+
+    queue->m_First = node;
+
+    g_UsedCount--;
+    g_AvailableCount++;
+
+    return 1;
+}
+
 void initializeMemoryQueue(MemoryQueue* queue, Node* first) {
     Node* currentNode;
     Node* nextNode;
@@ -82,11 +102,15 @@ void initializeMemoryQueue(MemoryQueue* queue, Node* first) {
         nextNodeAddress = (U32)currentNode + sizeof(Node) + sizeof(Envelope) + BLOCK_SIZE;
         nextNode = (Node*)nextNodeAddress;
         currentNode->m_Next = nextNode;
+        currentNode->m_Owner = NO_OWNER;
+        currentNode->m_ChargedTo = NO_OWNER;
         currentNode = nextNode;
     }
 
     // make sure last node points to null
     currentNode->m_Next = (Node *)NULL;
+    currentNode->m_Owner = NO_OWNER;
+    currentNode->m_ChargedTo = NO_OWNER;
 
     queue->m_First = first;
     queue->m_Last = currentNode;
@@ -34,6 +34,16 @@ Node* dequeueNode(MemoryQueue* queue);
  */
 int enqueueNode(MemoryQueue* queue, Node* node);
 
+/**
+ * Adds the specified Node to the front of the queue, so that it is the next
+ * Node dequeued.
+ * 
+ * @param   queue The memory queue to operate on.
+ * @param   node The Node to add.
+ * @return  The success (1) or failure (0) of the operation.
+ */
+int pushNode(MemoryQueue* queue, Node* node);
+
 /**
  * Initializes the queue.
  * 
@@ -5,6 +5,17 @@
 
 #include "MessageQueue.h"
 
+/**
+ * Checks whether envelope a expires strictly before envelope b. Expiry is
+ * compared by deadline (expiry plus slack) in milliseconds first, then by the
+ * microsecond offset.
+ */
+static int expiresBefore(Envelope* a, Envelope* b) {
+    int deadlineA = a->m_Expiry + a->m_Slack;
+    int deadlineB = b->m_Expiry + b->m_Slack;
+    return deadlineA < deadlineB || (deadlineA == deadlineB && a->m_ExpiryOffset < b->m_ExpiryOffset);
+}
+
 Envelope* dequeueEnvelope(MessageQueue* queue) {
     Envelope* front = queue->m_First; // this will be NULL if the queue is empty
 
@@ -59,9 +70,9 @@ int insertEnvelope(MessageQueue* queue, Envelope* envelope) {
     Envelope* currentEnvelope;
     Envelope* nextEnvelope;
     
-    if (isEmptyMessageQueue(queue) || envelope->m_Expiry >= queue->m_Last->m_Expiry) {
+    if (isEmptyMessageQueue(queue) || !expiresBefore(envelope, queue->m_Last)) {
         return enqueueEnvelope(queue, envelope);
-    } else if (envelope->m_Expiry < queue->m_First->m_Expiry) {
+    } else if (expiresBefore(envelope, queue->m_First)) {
         // insert envelope at the front
         envelope->m_Next = queue->m_First;
         queue->m_First = envelope;
@@ -71,7 +82,7 @@ int insertEnvelope(MessageQueue* queue, Envelope* envelope) {
     currentEnvelope = queue->m_First;
     nextEnvelope = currentEnvelope->m_Next;
     
-    while (currentEnvelope != queue->m_Last && envelope->m_Expiry >= nextEnvelope->m_Expiry) {
+    while (currentEnvelope != queue->m_Last && !expiresBefore(envelope, nextEnvelope)) {
         currentEnvelope = nextEnvelope;
         nextEnvelope = currentEnvelope->m_Next;
     }
@@ -81,6 +92,24 @@ int insertEnvelope(MessageQueue* queue, Envelope* envelope) {
     return RTX_OK;
 }
 
+Envelope* removeNextEnvelope(MessageQueue* queue, Envelope* previous) {
+    Envelope* envelope;
+
+    if (previous == NULL) {
+        return dequeueEnvelope(queue);
+    }
+
+    envelope = previous->m_Next;
+    if (envelope != NULL) {
+        previous->m_Next = envelope->m_Next;
+        if (queue->m_Last == envelope) {
+            queue->m_Last = previous;
+        }
+        envelope->m_Next = NULL;
+    }
+    return envelope;
+}
+
 int isEmptyMessageQueue(MessageQueue* queue) {
     return queue->m_First == NULL;
 }
@@ -61,7 +61,8 @@ void initializeMessageQueue(MessageQueue* queue);
 
 /**
  * Inserts the specified Envelope at the correct position in the queue (queue
- * is sorted by ascending expiry time).
+ * is sorted by ascending deadline, i.e. expiry time plus slack, then by
+ * ascending microsecond offset).
  * 
  * @param   queue The message queue to operate on.
  * @param   envelope The Envelope to add.
@@ -69,6 +70,16 @@ void initializeMessageQueue(MessageQueue* queue);
  */
 int insertEnvelope(MessageQueue* queue, Envelope* envelope);
 
+/**
+ * Removes the Envelope that follows the specified Envelope.
+ * 
+ * @param   queue The message queue to operate on.
+ * @param   previous The Envelope before the one to remove, or NULL to remove
+ *                   the first Envelope.
+ * @return  The removed Envelope, or NULL if there is none.
+ */
+Envelope* removeNextEnvelope(MessageQueue* queue, Envelope* previous);
+
 /**
  * Checks whether the queue is empty.
  * 
@@ -4,33 +4,37 @@
  */
 
 #include "PriorityQueue.h"
+#include "String.h"
+
+#include <LPC17xx.h>
+
+#define PRIORITY_BIT(priority) (0x80000000UL >> (priority))
 
 PCB* dequeueAtPriority(PriorityQueue* priorityQueue, int priority) {
     PCB* front = NULL;
 
     if (priority >= PRIVILEGED && priority <= NULL_PRIORITY) {
-        front = dequeue(getQueueAtPriority(priorityQueue, priority));
+        ProcessQueue* queue = getQueueAtPriority(priorityQueue, priority);
+        front = dequeue(queue);
+        if (isEmptyProcessQueue(queue)) {
+            priorityQueue->m_Occupied &= ~PRIORITY_BIT(priority);
+        }
     }
     return front;
 }
 
 PCB* dequeueHighest(PriorityQueue* priorityQueue) {
-    PCB* front = NULL;
-    int i;
-
-    for (i = 0; i < NUM_PRIORITIES; ++i) {
-        front = dequeue(getQueueAtPriority(priorityQueue, i));
-        if (front != NULL) {
-            break;
-        }
+    if (priorityQueue->m_Occupied == 0) {
+        return NULL;
     }
-    return front;
+    return dequeueAtPriority(priorityQueue, __CLZ(priorityQueue->m_Occupied));
 }
 
 int enqueueAtPriority(PriorityQueue* priorityQueue, PCB* process) {
     if (process->m_Priority < PRIVILEGED || process->m_Priority > NULL_PRIORITY) {
         return -1;
     }
+    priorityQueue->m_Occupied |= PRIORITY_BIT(process->m_Priority);
     return enqueue(getQueueAtPriority(priorityQueue, process->m_Priority), process);
 }
 
@@ -40,17 +44,31 @@ ProcessQueue* getQueueAtPriority(PriorityQueue* priorityQueue, int priority) {
 
 void initializePriorityQueue(PriorityQueue* priorityQueue) {
     int i;
+    priorityQueue->m_Occupied = 0;
     for (i = 0; i < NUM_PRIORITIES; ++i) {
         initializeQueue(getQueueAtPriority(priorityQueue, i));
     }
 }
 
 int isEmptyPriorityQueue(PriorityQueue* priorityQueue) {
-    int i;
-    for (i = 0; i < NUM_PRIORITIES; ++i) {
-        if (!isEmptyProcessQueue(&priorityQueue->m_Queues[i])) {
-            return 0;
-        }
+    return priorityQueue->m_Occupied == 0;
+}
+
+PCB* peekHighest(PriorityQueue* priorityQueue) {
+    if (priorityQueue->m_Occupied == 0) {
+        return NULL;
+    }
+    return getQueueAtPriority(priorityQueue, __CLZ(priorityQueue->m_Occupied))->m_First;
+}
+
+int removeAtPriority(PriorityQueue* priorityQueue, PCB* process) {
+    ProcessQueue* queue = getQueueAtPriority(priorityQueue, process->m_Priority);
+
+    if (removeProcess(queue, process) == NULL) {
+        return 0;
+    }
+    if (isEmptyProcessQueue(queue)) {
+        priorityQueue->m_Occupied &= ~PRIORITY_BIT(process->m_Priority);
     }
     return 1;
 }
@@ -61,8 +79,7 @@ void serializePriorityQueue(PriorityQueue* priorityQueue, char message[],  int s
     for (i = 0; i < NUM_PRIORITIES; i++) {
         message[j] = 'P';
         j++;
-        message[j] = i + '0';
-        j++;
+        j += strdecimal(i, &message[j]);
         message[j] = ':';
         j++;
         message[j] = ' ';
@@ -76,13 +93,10 @@ void serializePriorityQueue(PriorityQueue* priorityQueue, char message[],  int s
     message[j] = '\0';
 }
 
-int updateProcessPriority(PriorityQueue* queue, int processId, int oldPriority, int newPriority) {
-    PCB* process = removeProcess(getQueueAtPriority(queue, oldPriority), processId);
-    
-    if (process == NULL) {
+int updateProcessPriority(PriorityQueue* queue, PCB* process, int newPriority) {
+    if (!removeAtPriority(queue, process)) {
         return 0; // error
-    } else {
-        process->m_Priority = newPriority;
-        return enqueue(getQueueAtPriority(queue, newPriority), process);
     }
+    process->m_Priority = newPriority;
+    return enqueueAtPriority(queue, process);
 }
@@ -12,9 +12,12 @@
 
 /**
  * Priority queue structure for managing processes. Contains an underlying
- * array of process queues; one queue for each priority level.
+ * array of process queues; one queue for each priority level. Bit
+ * (31 - priority) of the occupancy mask is set while that level's queue is not
+ * empty, so the highest level is found with a single count leading zeros.
  */
 typedef struct PriorityQueue {
+    U32 m_Occupied;
     ProcessQueue m_Queues[NUM_PRIORITIES];
 } PriorityQueue;
 
@@ -71,6 +74,25 @@ void initializePriorityQueue(PriorityQueue* priorityQueue);
  */
 int isEmptyPriorityQueue(PriorityQueue* priorityQueue);
 
+/**
+ * Gets the first PCB of the highest level queue that is not empty, without
+ * removing it.
+ * 
+ * @param   priorityQueue The priority queue to operate on.
+ * @return  The first PCB of the highest level queue, or NULL if all queues are
+ *          empty.
+ */
+PCB* peekHighest(PriorityQueue* priorityQueue);
+
+/**
+ * Removes the specified PCB from the queue at its priority.
+ * 
+ * @param   priorityQueue The priority queue to operate on.
+ * @param   process The PCB to remove.
+ * @return  The success (1) or failure (0) of the operation.
+ */
+int removeAtPriority(PriorityQueue* priorityQueue, PCB* process);
+
 /**
  * Serializes the priority queue. For debugging.
  * 
@@ -81,16 +103,14 @@ int isEmptyPriorityQueue(PriorityQueue* priorityQueue);
 void serializePriorityQueue(PriorityQueue* priorityQueue, char message[],  int startIndex);
 
 /**
- * Attemps to find the process at the given old priority and update it to the
- * new priority.
+ * Moves a queued process to the back of the queue at the new priority.
  * 
  * @param   priorityQueue The priority queue to operate on.
- * @param   processId The process to update.
- * @param   oldPriority The old priority of the process.
+ * @param   process The process to update.
  * @param   newPriority The priority to change to.
- * @return  1 if the operation was successful, 0 if the process was not found
- *          at the given priority.
+ * @return  1 if the operation was successful, 0 if the process was not queued
+ *          at its current priority.
  */
-int updateProcessPriority(PriorityQueue* priorityQueue, int processId, int oldPriority, int newPriority);
+int updateProcessPriority(PriorityQueue* priorityQueue, PCB* process, int newPriority);
 
 #endif /* _PRIORITY_QUEUE_ */
@@ -4,6 +4,7 @@
  */
 
 #include "ProcessQueue.h"
+#include "String.h"
 
 PCB* dequeue(ProcessQueue* queue) {
     PCB* front = queue->m_First; // this will be NULL if the queue is empty
@@ -14,6 +15,8 @@ PCB* dequeue(ProcessQueue* queue) {
         // this is true if the queue only had one element
         if (queue->m_First == NULL) {
             queue->m_Last = NULL;
+        } else {
+            queue->m_First->m_Previous = NULL;
         }
         
         front->m_Next = NULL;
@@ -25,6 +28,7 @@ PCB* dequeue(ProcessQueue* queue) {
 int enqueue(ProcessQueue* queue, PCB* process) {
     // PCB will be the last element in the queue
     process->m_Next = NULL;
+    process->m_Previous = queue->m_Last;
 
     if (queue->m_First == NULL) {
         queue->m_First = process;
@@ -52,30 +56,26 @@ int isIProcess(int processID) {
     return (processID == TIMER_IPROCESS || processID == UART_IPROCESS);
 }
 
-PCB* removeProcess(ProcessQueue* queue, int processId) {
-    PCB* currentProcess = queue->m_First;
-    PCB* nextProcess = queue->m_First;
-    
-    if (currentProcess->m_PID == processId) {
-        queue->m_First = currentProcess->m_Next;
-        if (queue->m_First == NULL) {
-            queue->m_Last = NULL;
-        }
-        return currentProcess;
+PCB* removeProcess(ProcessQueue* queue, PCB* process) {
+    // dequeued processes have no neighbours, so only the first one can be linked
+    if (process->m_Previous == NULL && queue->m_First != process) {
+        return (PCB*)NULL;
     }
-    
-    while (currentProcess != NULL) {
-        nextProcess = currentProcess->m_Next;
-        if (nextProcess != NULL && nextProcess->m_PID == processId) {
-            currentProcess->m_Next = nextProcess->m_Next;
-            if (currentProcess->m_Next == NULL) {
-                queue->m_Last = NULL;
-            }
-            return nextProcess;
-        }
-        currentProcess = nextProcess;
+
+    if (process->m_Previous == NULL) {
+        queue->m_First = process->m_Next;
+    } else {
+        process->m_Previous->m_Next = process->m_Next;
+    }
+    if (process->m_Next == NULL) {
+        queue->m_Last = process->m_Previous;
+    } else {
+        process->m_Next->m_Previous = process->m_Previous;
     }
-    return (PCB*)NULL;
+
+    process->m_Next = NULL;
+    process->m_Previous = NULL;
+    return process;
 }
 
 int serializeProcessQueue(ProcessQueue* queue, char message[], int startIndex) {
@@ -83,12 +83,7 @@ int serializeProcessQueue(ProcessQueue* queue, char message[], int startIndex) {
     PCB* currentProcess = queue->m_First;
     
     while (currentProcess != NULL) {
-        if (currentProcess->m_PID / 10 > 0) { // assuming less than 99 processes
-            message[j] = (currentProcess->m_PID/10) + '0';
-            j++;
-        }
-        message[j] = (currentProcess->m_PID % 10) + '0';
-        j++;
+        j += strdecimal(currentProcess->m_PID, &message[j]);
         message[j] = ' ';
         j++;
         currentProcess = currentProcess->m_Next;
@@ -6,8 +6,9 @@
 #ifndef _PROCESS_QUEUE_
 #define _PROCESS_QUEUE_
 
-#include "Types.h"
+#include "Mailbox.h"
 #include "MessageQueue.h"
+#include "Types.h"
 
 /**
  * Process control block data structure. These act as the nodes in a process
@@ -15,12 +16,21 @@
  */
 typedef struct PCB {
     struct PCB* m_Next; // pointer to the next process in the queue
+    struct PCB* m_Previous; // pointer to the previous process in the queue
 
     U32 m_PID; // process id
     U32* m_ProcessSP; // pointer to top of process stack
     int m_Priority; // process priority
     ProcessState m_State; // current state of the process
-    struct MessageQueue m_Mailbox; // process mailbox
+    struct Mailbox m_Mailbox; // process mailbox
+    U32* m_StackBase; // lowest address of the process stack
+    U32 m_StackSize; // size of the process stack in bytes
+    int m_BlockCount; // memory blocks charged to the process
+    int m_BlockQuota; // most memory blocks that may be charged to the process
+    U32 m_MemoryWaitTotal; // milliseconds spent in BLOCKED_MEM
+    U32 m_MemoryWaitMax; // longest wait of one memory request, milliseconds
+    void* m_HandedBlock; // block handed over by a release while BLOCKED_MEM
+    void (*m_Entry)(); // entry point, for restarts
 } PCB;
 
 /**
@@ -72,13 +82,13 @@ int isEmptyProcessQueue(ProcessQueue* queue);
 int isIProcess(int processID);
 
 /**
- * Attempts to find and remove the process with the given ID.
+ * Unlinks a process from the queue in constant time.
  * 
  * @param   queue The process queue to operate on.
- * @param   processId The ID of the process to remove.
- * @return  The removed process, or NULL if the process was not found.
+ * @param   process The process to remove.
+ * @return  The removed process, or NULL if the process is not in the queue.
  */
-PCB* removeProcess(ProcessQueue* queue, int processId);
+PCB* removeProcess(ProcessQueue* queue, PCB* process);
 
 /**
  * Serializes the process queue. For debugging.
@@ -26,6 +26,25 @@ void strcpy(char source[], char destination[]) {
     destination[i] = source[i]; // null-terminated
 }
 
+int strdecimal(unsigned int value, char destination[]) {
+    unsigned int remaining = value;
+    int count = 0;
+    int i;
+
+    // count the digits, then fill them in from the back
+    do {
+        remaining /= 10;
+        count++;
+    } while (remaining != 0);
+
+    destination[count] = '\0';
+    for (i = count - 1; i >= 0; i--) {
+        destination[i] = value % 10 + '0';
+        value /= 10;
+    }
+    return count;
+}
+
 int strequals(char a[], char b[]) {
     int i = 0;
     
@@ -38,6 +57,17 @@ int strequals(char a[], char b[]) {
     return (a[i] == '\0' && b[i] == '\0');
 }
 
+int strhex(unsigned int value, char destination[]) {
+    int i;
+
+    for (i = 7; i >= 0; i--) {
+        destination[i] = "0123456789ABCDEF"[value & 0xF];
+        value >>= 4;
+    }
+    destination[8] = '\0';
+    return 8;
+}
+
 int strlen(char source[]) {
     int count = 0;
     
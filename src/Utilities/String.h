@@ -24,6 +24,16 @@ int strcont(char source[], char find);
  */
 void strcpy(char source[], char destination[]);
 
+/**
+ * Writes the decimal representation of a number into a string, followed by a
+ * null terminator.
+ * 
+ * @param   value The number to write.
+ * @param   destination The string to write into.
+ * @return  The number of digits written.
+ */
+int strdecimal(unsigned int value, char destination[]);
+
 /**
  * Checks whether two strings are equal. This function assumes that both
  * strings are null-terminated.
@@ -34,6 +44,16 @@ void strcpy(char source[], char destination[]);
  */
 int strequals(char a[], char b[]);
 
+/**
+ * Writes the representation of a number as eight hexadecimal digits into a
+ * string, followed by a null terminator.
+ * 
+ * @param   value The number to write.
+ * @param   destination The string to write into.
+ * @return  The number of digits written (8).
+ */
+int strhex(unsigned int value, char destination[]);
+
 /**
  * Gets the length of a given null-terminated string.
  * 
@@ -17,8 +17,36 @@ typedef unsigned int U32;
  */
 typedef struct Node {
     struct Node* m_Next; // pointer to the next memory block in the queue
+    int m_Owner; // ID of the process holding the block, or NO_OWNER while free
+    int m_ChargedTo; // ID of the process that requested the block, or NO_OWNER
+    U32 m_Acquired; // timer tick (ms) at which the owner got the block
 } Node;
 
+/**
+ * Description of an allocated memory block, for leak reports.
+ */
+typedef struct BlockInfo {
+    void* m_Block; // the block, as returned by request_memory_block()
+    int m_Owner; // ID of the process holding the block
+    U32 m_Age; // milliseconds since the owner got the block
+} BlockInfo;
+
+/**
+ * Allocator telemetry since boot, for sizing the heap. The counts over m_Uptime
+ * give the allocation and release rates.
+ */
+typedef struct MemoryStats {
+    int m_FreeBlocks; // blocks free now
+    int m_MinFreeBlocks; // fewest blocks ever free
+    U32 m_BlockedEvents; // requests that had to wait in BLOCKED_MEM
+    U32 m_Requests; // blocks allocated
+    U32 m_Releases; // blocks released
+    U32 m_HandOvers; // released blocks handed straight to a process blocked on memory
+    U32 m_Uptime; // milliseconds since boot
+    U32 m_WaitTotal; // milliseconds the process of interest spent in BLOCKED_MEM
+    U32 m_WaitMax; // longest wait of one request of that process, milliseconds
+} MemoryStats;
+
 /**
  * Message envelope data structure for IPC.
  */
@@ -28,6 +56,8 @@ typedef struct Envelope {
     int m_SenderPID; // ID of source process
     int m_DestinationPID; // ID of destination process
     int m_Expiry; // message will be sent after this time is reached
+    int m_ExpiryOffset; // microseconds past m_Expiry (high resolution timers only)
+    int m_Slack; // message may be held up to this many ms past m_Expiry to coalesce wake-ups
 } Envelope;
 
 /**
@@ -38,4 +68,26 @@ typedef struct Letter {
     char m_Text[MAX_LETTER_LENGTH]; // message body
 } Letter;
 
+/**
+ * Maximum text length (including the null terminator) of a packed letter, a
+ * letter whose text fills the rest of its memory block. The BLOCK_SIZE bytes
+ * of a block follow its envelope.
+ */
+#define MAX_PACKED_LETTER_LENGTH (BLOCK_SIZE - sizeof(int))
+
+/**
+ * Maximum decoded length of a binary channel frame, payload plus CRC.
+ */
+#define MAX_FRAME_LENGTH (BLOCK_SIZE - 2 * sizeof(int))
+
+/**
+ * Frame data structure for the UART binary channel. A Frame is sent in place
+ * of a Letter, with m_Type set to BINARY_FRAME.
+ */
+typedef struct Frame {
+    int m_Type; // message type, BINARY_FRAME
+    int m_Length; // number of payload bytes
+    U8 m_Payload[MAX_FRAME_LENGTH]; // payload (followed by its CRC while being received)
+} Frame;
+
 #endif /* _TYPES_ */
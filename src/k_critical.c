@@ -0,0 +1,36 @@
+/**
+ * @file:   k_critical.c
+ * @brief:  Kernel critical sections
+ */
+
+#include "k_critical.h"
+
+#include <LPC17xx.h>
+
+/**
+ * Converts an NVIC priority level into a BASEPRI/priority register value (the
+ * priority lives in the top __NVIC_PRIO_BITS bits).
+ */
+#define PRIORITY_TO_BASEPRI(priority) ((priority) << (8 - __NVIC_PRIO_BITS))
+
+U32 enterCriticalSection(void) {
+    U32 previous = __get_BASEPRI();
+
+    // only ever raise the mask; a nested section must not lower it
+    if (previous == 0 || previous > PRIORITY_TO_BASEPRI(KERNEL_IRQ_PRIORITY)) {
+        __set_BASEPRI(PRIORITY_TO_BASEPRI(KERNEL_IRQ_PRIORITY));
+    }
+    return previous;
+}
+
+void exitCriticalSection(U32 previous) {
+    __set_BASEPRI(previous);
+}
+
+void initializeInterruptPriorities(void) {
+    // kernel calls run at the ceiling, so kernel interrupts cannot preempt them
+    NVIC_SetPriority(SVCall_IRQn, KERNEL_IRQ_PRIORITY);
+
+    // deferred kernel work runs below every peripheral interrupt
+    NVIC_SetPriority(PendSV_IRQn, (1 << __NVIC_PRIO_BITS) - 1);
+}
@@ -0,0 +1,34 @@
+/**
+ * @file:   k_critical.h
+ * @brief:  Kernel critical sections
+ */
+
+#ifndef K_CRITICAL_H_
+#define K_CRITICAL_H_
+
+#include "Utilities/Types.h"
+
+/**
+ * Enters a kernel critical section by raising BASEPRI to the kernel interrupt
+ * priority ceiling (KERNEL_IRQ_PRIORITY). Interrupts at or below the ceiling
+ * (TIMER0, UART0, PendSV) are held off; interrupts above it (the performance
+ * timer) are still serviced with no added latency. Critical sections nest.
+ * 
+ * @return  The previous BASEPRI value, to be passed to exitCriticalSection().
+ */
+U32 enterCriticalSection(void);
+
+/**
+ * Leaves a kernel critical section by restoring BASEPRI.
+ * 
+ * @param   previous The value returned by the matching enterCriticalSection().
+ */
+void exitCriticalSection(U32 previous);
+
+/**
+ * Assigns NVIC priorities to SVC and PendSV relative to the kernel ceiling.
+ * Peripheral priorities are assigned where each peripheral is initialized.
+ */
+void initializeInterruptPriorities(void);
+
+#endif /* ! K_CRITICAL_H_ */
@@ -5,8 +5,13 @@
 
 #include "k_memory.h"
 
+#include "k_critical.h"
 #include "k_process.h"
+#include "Trace.h"
 #include "Utilities/MemoryQueue.h"
+#include "Utilities/String.h"
+
+#include <LPC17xx.h>
 
 #ifdef DEBUG_0
 #include "printf.h"
@@ -23,6 +28,194 @@ MemoryQueue g_Heap;
  */
 static U32* s_stack_pointer;
 
+/**
+ * Start and end of the heap, pressure letter pool included. Stacks are never
+ * allocated below s_HeapEnd.
+ */
+static U32 s_HeapStart;
+static U32 s_HeapEnd;
+
+/**
+ * Free stack extent. Stacks released by exiting processes are kept in a list
+ * sorted by address, so that neighbouring extents can be merged.
+ */
+typedef struct StackExtent {
+    struct StackExtent* m_Next;
+    U32 m_Size; // bytes
+} StackExtent;
+
+/**
+ * Released stack space available for new processes.
+ */
+static StackExtent* s_FreeStacks;
+
+/**
+ * Memory pressure watermarks on the free block count, and whether the count
+ * has fallen to the low watermark without climbing back to the high one.
+ */
+static int s_LowWatermark;
+static int s_HighWatermark;
+static int s_MemoryLow;
+
+/**
+ * Processes subscribed to MEM_LOW and MEM_OK notifications, and those of them
+ * last sent MEM_LOW rather than MEM_OK, one bit per PID.
+ */
+static U32 s_PressureSubscribers[(NUM_PROCS + 31) / 32];
+static U32 s_PressureNotified[(NUM_PROCS + 31) / 32];
+
+/**
+ * Free blocks of the pressure letter pool, linked through m_Next. The pool
+ * lies between s_PressureStart and s_HeapEnd, apart from the heap, so that
+ * notifications neither draw on the reserves nor count against a quota.
+ */
+static Node* s_FreePressureLetters;
+static U32 s_PressureStart;
+
+/**
+ * Allocator telemetry (see MemoryStats).
+ */
+static int s_MinAvailable;
+static U32 s_BlockedEvents;
+static U32 s_RequestCount;
+static U32 s_ReleaseCount;
+static U32 s_HandOverCount;
+
+extern int g_AvailableCount;
+extern volatile uint32_t g_timer_count;
+
+/**
+ * Charges a newly allocated block to a process.
+ */
+static void chargeBlock(Node* node, int processID) {
+    node->m_Owner = processID;
+    node->m_ChargedTo = processID;
+    node->m_Acquired = g_timer_count;
+    g_ProcessTable[processID]->m_BlockCount++;
+
+    s_RequestCount++;
+    if (g_AvailableCount < s_MinAvailable) {
+        s_MinAvailable = g_AvailableCount;
+    }
+}
+
+/**
+ * Checks whether a node belongs to the pressure letter pool.
+ */
+static int isPressureLetter(Node* node) {
+    U32 address = (U32)node;
+
+    return address >= s_PressureStart && address < s_HeapEnd
+            && (address - s_PressureStart) % (sizeof(Node) + sizeof(Envelope) + BLOCK_SIZE) == 0;
+}
+
+/**
+ * Brings every subscriber up to date with the memory pressure state, sending
+ * MEM_LOW or MEM_OK to those last told otherwise. The text is the free block
+ * count. Subscribers left over when the pool runs dry are told when a letter
+ * comes back.
+ */
+static void notifyPressure(void) {
+    Node* node;
+    Letter* letter;
+    int processID;
+    U32 bit;
+    U32 stale;
+    int i;
+
+    for (i = 0; i < (NUM_PROCS + 31) / 32; i++) {
+        stale = s_PressureSubscribers[i] & (s_MemoryLow ? ~s_PressureNotified[i] : s_PressureNotified[i]);
+        while (stale != 0 && s_FreePressureLetters != NULL) {
+            processID = i * 32 + __CLZ(stale);
+            bit = 0x80000000UL >> __CLZ(stale);
+            stale &= ~bit;
+
+            node = s_FreePressureLetters;
+            s_FreePressureLetters = node->m_Next;
+            node->m_Next = NULL;
+            node->m_Owner = processID;
+            node->m_Acquired = g_timer_count;
+
+            letter = (Letter*)((U32)node + sizeof(Node) + sizeof(Envelope));
+            letter->m_Type = s_MemoryLow ? MEM_LOW : MEM_OK;
+            strdecimal(g_AvailableCount, letter->m_Text);
+            nonPreemptiveSendMessage(NULL_PROCESS, processID, letter);
+            s_PressureNotified[i] ^= bit;
+        }
+    }
+}
+
+/**
+ * Returns a letter to the pressure letter pool, and sends any notification
+ * that was waiting for one.
+ */
+static int releasePressureLetter(Node* node) {
+    if (node->m_Owner == NO_OWNER) {
+        return RTX_ERR; // already back in the pool
+    }
+    node->m_Owner = NO_OWNER;
+    node->m_Next = s_FreePressureLetters;
+    s_FreePressureLetters = node;
+    notifyPressure();
+    return RTX_OK;
+}
+
+/**
+ * Notifies the subscribers if an allocation took the free block count down to
+ * the low watermark.
+ */
+static void checkMemoryLow(void) {
+    if (!s_MemoryLow && g_AvailableCount <= s_LowWatermark) {
+        s_MemoryLow = 1;
+        notifyPressure();
+    }
+}
+
+/**
+ * Returns a block to the heap, refunds the process it was charged to and
+ * wakes a process that was waiting for it. The block goes back at the front
+ * of the heap, so a waiter is handed this very block.
+ */
+static int releaseNode(Node* node, int preempt) {
+    int chargedTo = node->m_ChargedTo;
+
+    pushNode(&g_Heap, node);
+    s_ReleaseCount++;
+    if (chargedTo != NO_OWNER) {
+        g_ProcessTable[chargedTo]->m_BlockCount--;
+    }
+    if (s_MemoryLow && g_AvailableCount >= s_HighWatermark) {
+        s_MemoryLow = 0;
+        notifyPressure();
+    }
+    return handleMemoryRelease(chargedTo, preempt);
+}
+
+/**
+ * Works out whether a process may take a block now.
+ *
+ * @return  RUNNING if it may, otherwise the state it must wait in.
+ */
+static ProcessState getRequestState(PCB* process) {
+// performance tests request the same block over and over, so the counts are
+// meaningless there
+#ifndef DEBUG_PERFORMANCE
+    if (process->m_BlockCount >= process->m_BlockQuota) {
+        return BLOCKED_QUOTA;
+    }
+    if (g_AvailableCount <= MEMORY_RESERVE && process->m_Priority != PRIVILEGED) {
+        return BLOCKED_MEM; // the rest is reserved for system processes
+    }
+    if (g_AvailableCount <= IPROCESS_RESERVE) {
+        return BLOCKED_MEM; // the rest is reserved for interrupt input
+    }
+#endif /* !DEBUG_PERFORMANCE */
+    if (isEmptyMemoryQueue(&g_Heap)) {
+        return BLOCKED_MEM;
+    }
+    return RUNNING;
+}
+
 /**
  * Memory layout:
 
@@ -63,6 +256,207 @@ U32* alloc_stack(U32 size_b) {
     return sp;
 }
 
+U32* allocateStack(U32 size_b) {
+    StackExtent** link = &s_FreeStacks;
+    StackExtent* extent;
+
+    size_b = (size_b + 7) & ~7; // keep every extent 8 bytes aligned
+
+    // first fit from released stacks, taking the top of the extent
+    while (*link != NULL) {
+        extent = *link;
+        if (extent->m_Size >= size_b) {
+            extent->m_Size -= size_b;
+            if (extent->m_Size == 0) {
+                *link = extent->m_Next;
+            }
+            return (U32*)((U32)extent + extent->m_Size);
+        }
+        link = &(extent->m_Next);
+    }
+
+    // otherwise grow the stack area down towards the heap
+    if ((U32)s_stack_pointer - s_HeapEnd < size_b) {
+        return NULL;
+    }
+    s_stack_pointer = (U32*)((U32)s_stack_pointer - size_b);
+    return s_stack_pointer;
+}
+
+void releaseStack(U32* base, U32 size_b) {
+    StackExtent** link = &s_FreeStacks;
+    StackExtent* previous = NULL;
+    StackExtent* extent = (StackExtent*)base;
+
+    while (*link != NULL && (U32)*link < (U32)base) {
+        previous = *link;
+        link = &((*link)->m_Next);
+    }
+
+    extent->m_Size = size_b;
+    extent->m_Next = *link;
+    *link = extent;
+
+    // merge with the following and preceding extents if they touch
+    if (extent->m_Next != NULL && (U32)extent + extent->m_Size == (U32)extent->m_Next) {
+        extent->m_Size += extent->m_Next->m_Size;
+        extent->m_Next = extent->m_Next->m_Next;
+    }
+    if (previous != NULL && (U32)previous + previous->m_Size == (U32)extent) {
+        previous->m_Size += extent->m_Size;
+        previous->m_Next = extent->m_Next;
+    }
+}
+
+int handOverBlock(PCB* process) {
+    Node* node;
+
+    if (getRequestState(process) != RUNNING) {
+        return 0;
+    }
+    node = dequeueNode(&g_Heap);
+    chargeBlock(node, process->m_PID);
+    process->m_HandedBlock = (void*)((U32)node + sizeof(Node) + sizeof(Envelope));
+    s_HandOverCount++;
+    checkMemoryLow();
+    return 1;
+}
+
+int isAllocatedBlock(Node* node) {
+    if (isPressureLetter(node)) {
+        return node->m_Owner != NO_OWNER;
+    }
+    return isValidNode(&g_Heap, node);
+}
+
+int releaseProcessMemory(int processID) {
+    Node* node;
+    U32 address;
+    int released = 0;
+
+    s_PressureSubscribers[processID / 32] &= ~(0x80000000UL >> (processID % 32));
+    g_ProcessTable[processID]->m_HandedBlock = NULL; // released with the rest
+
+    // pressure letters it holds go back to their pool
+    for (address = s_HeapStart; address < s_HeapEnd; address += sizeof(Node) + sizeof(Envelope) + BLOCK_SIZE) {
+        node = (Node*)address;
+        if (node->m_Owner == processID) {
+            if (isPressureLetter(node)) {
+                releasePressureLetter(node);
+            } else {
+                releaseNode(node, 0);
+            }
+            released++;
+        } else if (node->m_ChargedTo == processID) {
+            node->m_ChargedTo = NO_OWNER; // held elsewhere; nothing left to refund
+        }
+    }
+    g_ProcessTable[processID]->m_BlockCount = 0;
+    return released;
+}
+
+int k_get_oldest_blocks(BlockInfo info[], int count) {
+    Node* node;
+    U32 address;
+    U32 age;
+    int found = 0;
+    int i;
+
+    if (info == NULL || count <= 0) {
+        return 0;
+    }
+
+    // insertion sort the allocated blocks into info, oldest first, keeping
+    // only the first count
+    for (address = s_HeapStart; address < s_PressureStart; address += sizeof(Node) + sizeof(Envelope) + BLOCK_SIZE) {
+        node = (Node*)address;
+        if (node->m_Owner == NO_OWNER) {
+            continue;
+        }
+
+        age = g_timer_count - node->m_Acquired;
+        i = (found < count) ? found++ : count;
+        while (i > 0 && info[i - 1].m_Age < age) {
+            if (i < count) {
+                info[i] = info[i - 1];
+            }
+            i--;
+        }
+        if (i < count) {
+            info[i].m_Block = (void*)(address + sizeof(Node) + sizeof(Envelope));
+            info[i].m_Owner = node->m_Owner;
+            info[i].m_Age = age;
+        }
+    }
+    return found;
+}
+
+int k_get_memory_stats(int process_id, MemoryStats* stats) {
+    if (process_id < 0 || process_id >= NUM_PROCS || stats == NULL) {
+        return RTX_ERR;
+    }
+    stats->m_FreeBlocks = g_AvailableCount;
+    stats->m_MinFreeBlocks = s_MinAvailable;
+    stats->m_BlockedEvents = s_BlockedEvents;
+    stats->m_Requests = s_RequestCount;
+    stats->m_Releases = s_ReleaseCount;
+    stats->m_HandOvers = s_HandOverCount;
+    stats->m_Uptime = g_timer_count;
+    stats->m_WaitTotal = g_ProcessTable[process_id]->m_MemoryWaitTotal;
+    stats->m_WaitMax = g_ProcessTable[process_id]->m_MemoryWaitMax;
+    return RTX_OK;
+}
+
+int k_get_owned_blocks(int process_id) {
+    U32 address;
+    int owned = 0;
+
+    if (process_id < 0 || process_id >= NUM_PROCS) {
+        return RTX_ERR;
+    }
+    for (address = s_HeapStart; address < s_PressureStart; address += sizeof(Node) + sizeof(Envelope) + BLOCK_SIZE) {
+        if (((Node*)address)->m_Owner == process_id) {
+            owned++;
+        }
+    }
+    return owned;
+}
+
+int k_get_memory_usage(int process_id, int* quota) {
+    if (process_id < 0 || process_id >= NUM_PROCS || g_ProcessTable[process_id]->m_State == EXITED) {
+        return RTX_ERR;
+    }
+    if (quota != NULL) {
+        *quota = g_ProcessTable[process_id]->m_BlockQuota;
+    }
+    return g_ProcessTable[process_id]->m_BlockCount;
+}
+
+int k_reclaim_memory(int process_id) {
+    PCB* process;
+    U32 criticalSection;
+    int released;
+
+    // only system processes may reset others
+    if (g_CurrentProcess->m_Priority != PRIVILEGED || process_id < 0 || process_id >= NUM_PROCS) {
+        return RTX_ERR;
+    }
+    process = g_ProcessTable[process_id];
+    // system processes and i-processes keep blocks in structures of their own
+    if (process->m_State == EXITED || process->m_Priority < HIGH || process->m_Priority > LOWEST) {
+        return RTX_ERR;
+    }
+
+    // the process' locals and private queues still point at its blocks, so
+    // it starts over rather than carrying on without them
+    criticalSection = enterCriticalSection();
+    released = restartProcess(process);
+    exitCriticalSection(criticalSection);
+
+    k_release_processor(); // let any process that was waiting for memory run
+    return released;
+}
+
 int k_release_memory_block(void *p_mem_blk) {
     Node* memoryToFree = (Node*)((U32)p_mem_blk - sizeof(Node) - sizeof(Envelope)); // if the node is valid, it will occur at this address
 
@@ -70,25 +464,121 @@ int k_release_memory_block(void *p_mem_blk) {
    printf("k_release_memory_block: releasing block @ 0x%x\n", p_mem_blk);
 #endif /* ! DEBUG_0 */
 
+    if (isPressureLetter(memoryToFree)) {
+        trace(TRACE_MEM_RELEASE, g_CurrentProcess->m_PID, (U32)p_mem_blk);
+        return releasePressureLetter(memoryToFree);
+    }
     if (isValidNode(&g_Heap, memoryToFree)) {
-        enqueueNode(&g_Heap, memoryToFree); // if valid, add back to heap
-        return handleMemoryRelease(1); // allow preemption
+        trace(TRACE_MEM_RELEASE, g_CurrentProcess->m_PID, (U32)p_mem_blk);
+        return releaseNode(memoryToFree, 1); // if valid, add back to heap and allow preemption
     }
     return RTX_ERR;
 }
 
 void* k_request_memory_block(void) {
+    Node* node;
+    void* block;
+    ProcessState state;
+    U32 blockedAt;
+    U32 waited = 0;
+    int blocked = 0;
+
 #ifdef DEBUG_0
     printf("k_request_memory_block: entering...\n");
 #endif /* ! DEBUG_0 */
 
-    while (isEmptyMemoryQueue(&g_Heap)) {
-        g_CurrentProcess->m_State = BLOCKED_MEM;
+    g_CurrentProcess->m_HandedBlock = NULL;
+    while (g_CurrentProcess->m_HandedBlock == NULL && (state = getRequestState(g_CurrentProcess)) != RUNNING) {
+        if (state == BLOCKED_QUOTA) {
+            trace(TRACE_MEM_QUOTA, g_CurrentProcess->m_PID, g_CurrentProcess->m_BlockQuota);
+        } else {
+            trace(TRACE_MEM_BLOCKED, g_CurrentProcess->m_PID, g_CurrentProcess->m_Priority);
+        }
+        g_CurrentProcess->m_State = state;
+        blockedAt = g_timer_count;
         k_release_processor();
+        if (state == BLOCKED_MEM) {
+            if (!blocked) {
+                s_BlockedEvents++; // once per request, however often it is woken
+                blocked = 1;
+            }
+            waited += g_timer_count - blockedAt;
+        }
+    }
+    if (blocked) {
+        g_CurrentProcess->m_MemoryWaitTotal += waited;
+        if (waited > g_CurrentProcess->m_MemoryWaitMax) {
+            g_CurrentProcess->m_MemoryWaitMax = waited;
+        }
+    }
+
+    if (g_CurrentProcess->m_HandedBlock != NULL) {
+        // a release handed us a block while we were waiting
+        block = g_CurrentProcess->m_HandedBlock;
+        g_CurrentProcess->m_HandedBlock = NULL;
+        trace(TRACE_MEM_REQUEST, g_CurrentProcess->m_PID, (U32)block);
+        return block;
     }
 
     // return the next node offset by the size of the Node
-    return (void*)((U32)dequeueNode(&g_Heap) + sizeof(Node) + sizeof(Envelope));
+    node = dequeueNode(&g_Heap);
+    chargeBlock(node, g_CurrentProcess->m_PID);
+    block = (void*)((U32)node + sizeof(Node) + sizeof(Envelope));
+    trace(TRACE_MEM_REQUEST, g_CurrentProcess->m_PID, (U32)block);
+    checkMemoryLow();
+    return block;
+}
+
+int k_set_memory_quota(int process_id, int quota) {
+    PCB* process;
+
+    // a user process could otherwise lift its own limit
+    if (g_CurrentProcess->m_Priority != PRIVILEGED) {
+        return RTX_ERR;
+    }
+    if (process_id < 0 || process_id >= NUM_PROCS || quota < 1 || quota > NUM_BLOCKS) {
+        return RTX_ERR;
+    }
+    process = g_ProcessTable[process_id];
+    if (process->m_State == EXITED) {
+        return RTX_ERR;
+    }
+
+    process->m_BlockQuota = quota;
+    if (process->m_State == BLOCKED_QUOTA && process->m_BlockCount < quota) {
+        return handleMemoryRelease(process_id, 1); // room under the new quota
+    }
+    return RTX_OK;
+}
+
+int k_set_memory_watermarks(int low, int high) {
+    if (g_CurrentProcess->m_Priority != PRIVILEGED) {
+        return RTX_ERR; // the watermarks apply to every subscriber
+    }
+    if (low < 0 || low >= high || high > NUM_BLOCKS) {
+        return RTX_ERR;
+    }
+    s_LowWatermark = low;
+    s_HighWatermark = high;
+    return RTX_OK;
+}
+
+int k_subscribe_memory_pressure(int subscribe) {
+    int processID = g_CurrentProcess->m_PID;
+    U32 bit = 0x80000000UL >> (processID % 32);
+    U32 criticalSection;
+
+    // interrupts allocate and release blocks, and so may send notifications
+    criticalSection = enterCriticalSection();
+    if (subscribe && (s_PressureSubscribers[processID / 32] & bit) == 0) {
+        s_PressureSubscribers[processID / 32] |= bit;
+        s_PressureNotified[processID / 32] &= ~bit;
+        notifyPressure(); // MEM_LOW straight away if memory is already low
+    } else if (!subscribe) {
+        s_PressureSubscribers[processID / 32] &= ~bit;
+    }
+    exitCriticalSection(criticalSection);
+    return RTX_OK;
 }
 
 void memory_init(void) {
@@ -111,11 +601,44 @@ void memory_init(void) {
 
     // initialize heap
     initializeMemoryQueue(&g_Heap, (Node*)p_end);
+    s_HeapStart = (U32)p_end;
+    s_PressureStart = (U32)p_end + NUM_BLOCKS * (sizeof(Node) + sizeof(Envelope) + BLOCK_SIZE);
+    s_FreeStacks = NULL;
+
+    // the pressure letter pool follows the heap blocks
+    s_FreePressureLetters = NULL;
+    s_HeapEnd = s_PressureStart;
+    for (i = 0; i < PRESSURE_LETTERS; i++) {
+        Node* node = (Node*)s_HeapEnd;
+
+        node->m_Owner = NO_OWNER;
+        node->m_ChargedTo = NO_OWNER;
+        node->m_Next = s_FreePressureLetters;
+        s_FreePressureLetters = node;
+        s_HeapEnd += sizeof(Node) + sizeof(Envelope) + BLOCK_SIZE;
+    }
+
+    s_MinAvailable = NUM_BLOCKS;
+    s_BlockedEvents = 0;
+    s_RequestCount = 0;
+    s_ReleaseCount = 0;
+    s_HandOverCount = 0;
+
+    // no subscribers yet
+    s_LowWatermark = MEMORY_LOW_WATERMARK;
+    s_HighWatermark = MEMORY_HIGH_WATERMARK;
+    s_MemoryLow = 0;
+    for (i = 0; i < (NUM_PROCS + 31) / 32; i++) {
+        s_PressureSubscribers[i] = 0;
+        s_PressureNotified[i] = 0;
+    }
 }
 
-void* nonBlockingRequestMemory(void) {
+void* nonBlockingRequestMemory(int ownerID) {
     Node* memoryBlock = dequeueNode(&g_Heap);
     if (memoryBlock != NULL) {
+        chargeBlock(memoryBlock, ownerID);
+        checkMemoryLow();
         // we retrieved a memory block
         // add the size of the header before returning it
         return (void*)((U32)memoryBlock + sizeof(Node) + sizeof(Envelope));
@@ -127,9 +650,11 @@ void* nonBlockingRequestMemory(void) {
 int nonPreemptiveReleaseMemory(void* memory) {
     Node* memoryToFree = (Node*)((U32)memory - sizeof(Node) - sizeof(Envelope)); // if the node is valid, it will occur at this address
     
+    if (isPressureLetter(memoryToFree)) {
+        return releasePressureLetter(memoryToFree);
+    }
     if (isValidNode(&g_Heap, memoryToFree)) {
-        enqueueNode(&g_Heap, memoryToFree); // if valid, add back to heap
-        return handleMemoryRelease(0); // do not allow preemption
+        return releaseNode(memoryToFree, 0); // if valid, add back to heap; do not allow preemption
     }
     return RTX_ERR;
 }
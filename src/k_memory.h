@@ -18,7 +18,7 @@ extern PCB* g_CurrentProcess; // points to the current RUNNING process
  * RVCT Linker User Guide).
  */
 extern unsigned int Image$$RW_IRAM1$$ZI$$Limit; 
-extern PROC_INIT g_proc_table[NUM_PROCS];
+extern PROC_INIT g_proc_table[NUM_BOOT_PROCS];
 extern PCB* g_ProcessTable[NUM_PROCS]; // kernel process table
 
 /**
@@ -29,6 +29,109 @@ extern PCB* g_ProcessTable[NUM_PROCS]; // kernel process table
  */
 U32* alloc_stack(U32 size_b);
 
+/**
+ * Allocates stack space for a process, from released stacks if possible and
+ * otherwise from the free space between the heap and the existing stacks.
+ * 
+ * @param   size_b Size of stack (in bytes) to allocate, rounded up to 8 bytes.
+ * @return  The lowest address of the stack, or NULL if there is no room.
+ */
+U32* allocateStack(U32 size_b);
+
+/**
+ * Returns stack space allocated with allocateStack() for reuse.
+ * 
+ * @param   base The lowest address of the stack.
+ * @param   size_b The size of the stack in bytes, as rounded by allocateStack().
+ */
+void releaseStack(U32* base, U32 size_b);
+
+/**
+ * Gives a free block to a process blocked on memory, if it may take one now.
+ * Called on a release, it gives the block that was just released. The block
+ * is charged to the process and left in its m_HandedBlock for
+ * k_request_memory_block() to return, so that no other process can take it
+ * before the waiter runs.
+ * 
+ * @param   process The waiting process.
+ * @return  1 if the process was given a block, 0 otherwise.
+ */
+int handOverBlock(PCB* process);
+
+/**
+ * Checks whether a node heads a block that is in use: an allocated heap block
+ * or a pressure letter that has been sent.
+ * 
+ * @param   node The node of interest.
+ * @return  1 if the block is in use, 0 otherwise.
+ */
+int isAllocatedBlock(Node* node);
+
+/**
+ * Returns every memory block held by the specified process to the OS,
+ * including the messages waiting in its mailbox. This is non-preemptive.
+ * 
+ * @param   processID The ID of the process whose blocks to release.
+ * @return  The number of blocks released.
+ */
+int releaseProcessMemory(int processID);
+
+/**
+ * Finds the allocated memory blocks that have been with their current owner
+ * the longest. Blocks that sit in private queues or in mailboxes nobody reads
+ * show up here.
+ * 
+ * @param   info Array to fill, oldest block first.
+ * @param   count The size of the info array.
+ * @return  The number of entries filled in.
+ */
+int k_get_oldest_blocks(BlockInfo info[], int count);
+
+/**
+ * Gets the allocator telemetry: free block low-water mark, blocked requests,
+ * allocation and release counts, and the time a process has spent waiting in
+ * BLOCKED_MEM.
+ * 
+ * @param   process_id The ID of the process whose waits to report.
+ * @param   stats The structure to fill in.
+ * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
+ */
+int k_get_memory_stats(int process_id, MemoryStats* stats);
+
+/**
+ * Counts the memory blocks a process holds: blocks it requested or received
+ * and has not sent on or released, including messages in its mailbox.
+ * 
+ * @param   process_id The ID of the process of interest.
+ * @return  The number of blocks, or RTX_ERR if the ID is invalid.
+ */
+int k_get_owned_blocks(int process_id);
+
+/**
+ * Gets the number of memory blocks charged to a process. A block is charged
+ * to the process that requested it until it is released, wherever it is sent.
+ * 
+ * @param   process_id The ID of the process of interest.
+ * @param   quota If not NULL, the process' block quota is written into this
+ *                address.
+ * @return  The number of blocks charged to the process, or RTX_ERR if there is
+ *          no such process.
+ */
+int k_get_memory_usage(int process_id, int* quota);
+
+/**
+ * Releases every memory block a user process holds, including the messages
+ * waiting in its mailbox and its delayed mail, and restarts it from its
+ * entry point with its priority and quota. For resetting a misbehaving
+ * worker; only system (PRIVILEGED) processes may call it. This primitive is
+ * preemptive.
+ * 
+ * @param   process_id The ID of the process to reclaim from.
+ * @return  The number of blocks released, or RTX_ERR if the caller is not a
+ *          system process or the target is not a live user process.
+ */
+int k_reclaim_memory(int process_id);
+
 /**
  * Returns the given memory block to the OS. This primitive is preemptive.
  * 
@@ -38,7 +141,11 @@ U32* alloc_stack(U32 size_b);
 int k_release_memory_block(void* p_mem_blk);
 
 /**
- * Gets a new block of memory, if available. This primitive is blocking.
+ * Gets a new block of memory, if available. This primitive is blocking. A
+ * process with its quota of blocks waits (BLOCKED_QUOTA) until one of them is
+ * released; other than PRIVILEGED processes also wait (BLOCKED_MEM) once only
+ * MEMORY_RESERVE blocks are left, and PRIVILEGED processes once only
+ * IPROCESS_RESERVE are left.
  * 
  * @return  A pointer to a memory block.
  */
@@ -49,12 +156,54 @@ void* k_request_memory_block(void);
  */
 void memory_init(void);
 
+/**
+ * Sets the most memory blocks that may be charged to a process. Processes
+ * start with USER_BLOCK_QUOTA at user priorities and NUM_BLOCKS otherwise.
+ * Only system processes may change quotas.
+ * 
+ * @param   process_id The ID of the process to change.
+ * @param   quota The new quota, from 1 to NUM_BLOCKS.
+ * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
+ */
+int k_set_memory_quota(int process_id, int quota);
+
+/**
+ * Sets the memory pressure watermarks. Subscribers are sent MEM_LOW when an
+ * allocation leaves no more than low blocks free, and MEM_OK when a release
+ * brings the free count back up to high. Defaults to MEMORY_LOW_WATERMARK and
+ * MEMORY_HIGH_WATERMARK. Only system processes may change them.
+ * 
+ * @param   low The low watermark, from 0.
+ * @param   high The high watermark, above low and at most NUM_BLOCKS.
+ * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
+ */
+int k_set_memory_watermarks(int low, int high);
+
+/**
+ * Subscribes the current process to memory pressure notifications, or cancels
+ * its subscription. MEM_LOW and MEM_OK letters come from NULL_PROCESS with the
+ * free block count as text, and are released by the subscriber as usual.
+ * They are written in a pool of PRESSURE_LETTERS blocks kept apart from the
+ * heap, so they take nothing from the reserves and are not charged to anyone.
+ * If the pool runs dry, subscribers are brought up to date as letters are
+ * released. A process subscribing while memory is low is sent MEM_LOW
+ * straight away.
+ * 
+ * @param   subscribe 1 to subscribe, 0 to cancel.
+ * @return  RTX_OK.
+ */
+int k_subscribe_memory_pressure(int subscribe);
+
 /**
  * Gets a new block of memory, if available. This primitive is non-blocking.
+ * It may take the reserved blocks that request_memory_block() leaves for
+ * i-processes.
  * 
+ * @param   ownerID The ID of the process (usually an i-process) that will
+ *                  hold the block.
  * @return  A pointer to a memory block, or NULL if no memory is available.
  */
-void* nonBlockingRequestMemory(void);
+void* nonBlockingRequestMemory(int ownerID);
 
 /**
  * Returns the given memory block to the OS. This primitive is non-preemptive.
@@ -5,9 +5,17 @@
 
 #include "k_process.h"
 
+#include "k_critical.h"
+#include "k_memory.h"
 #include "Polling/uart_polling.h"
+#include "SystemProcesses.h"
+#include "Task.h"
+#include "Timer.h"
+#include "Trace.h"
+#include "UART.h"
 #include "Utilities/MemoryQueue.h"
 #include "Utilities/MessageQueue.h"
+#include "Utilities/String.h"
 
 #include <LPC17xx.h>
 #include <system_LPC17xx.h>
@@ -24,7 +32,7 @@ PCB* g_CurrentProcess;
 /**
  * Process initialization table for populating the kernel process table.
  */
-PROC_INIT g_proc_table[NUM_PROCS];
+PROC_INIT g_proc_table[NUM_BOOT_PROCS];
 
 /**
  * Kernel process table.
@@ -32,9 +40,7 @@ PROC_INIT g_proc_table[NUM_PROCS];
 PCB* g_ProcessTable[NUM_PROCS];
 
 /**
- * Array of all queued states. This array is iterated when the priority of a
- * process is changed and we must find the process to remove and re-enqueue it.
-
+ * Array of all queued states, indexed by the debug serialization queue number.
  */
 static PriorityQueue* s_MasterPQs[QUEUED_STATES];
 
@@ -50,6 +56,178 @@ static PriorityQueue s_ReadyQueue;
  */
 static PriorityQueue s_BlockedOnMemoryQueue;
 
+/**
+ * Bitmap of processes that are blocked on receive; bit (31 - PID % 32) of
+ * word PID / 32. These processes are in no queue.
+ */
+static U32 s_BlockedOnReceive[(NUM_PROCS + 31) / 32];
+
+/**
+ * Unused PCBs, available to create_process().
+ */
+static ProcessQueue s_FreeProcesses;
+
+/**
+ * Process that exited and is still running on its stack. Its stack and PCB
+ * are reclaimed by the next process switch, once another stack is in use.
+ */
+static PCB* s_ExitedProcess;
+
+/**
+ * Set by an interrupt that woke a process while the deferred context was
+ * running, so that PendSV reschedules once it finishes.
+ */
+static volatile int s_SwitchRequested;
+
+/**
+ * Builds the initial exception stack frame of a process on its (painted)
+ * stack, so that it starts at its entry point when next scheduled as NEW.
+ */
+static void initializeContext(PCB* process) {
+    U32* sp;
+    int j;
+
+    // paint the stack so its high-water mark can be measured later
+    sp = (U32*)((U32)process->m_StackBase + process->m_StackSize);
+    while (sp > process->m_StackBase) {
+        *(--sp) = STACK_PAINT;
+    }
+
+    sp = (U32*)((U32)process->m_StackBase + process->m_StackSize);
+    *(--sp)  = INITIAL_xPSR; // user process initial xPSR
+    *(--sp)  = (U32)process->m_Entry; // PC contains the entry point of the process
+    for ( j = 0; j < 6; j++ ) { // R0-R3, R12 are cleared with 0
+        *(--sp) = 0x0;
+    }
+    process->m_ProcessSP = sp;
+    process->m_State = NEW;
+}
+
+/**
+ * Sets up a process to start at the given entry point: allocates its stack,
+ * builds the initial exception stack frame and empties its mailbox.
+ *
+ * @return  RTX_OK, or RTX_ERR if there is no room for the stack.
+ */
+static int initializeProcess(PCB* process, int priority, U32 stackSize, void (*entry)()) {
+    process->m_StackSize = (stackSize + 7) & ~7;
+    process->m_StackBase = allocateStack(process->m_StackSize);
+    if (process->m_StackBase == NULL) {
+        return RTX_ERR;
+    }
+
+    process->m_Priority = priority;
+    process->m_BlockCount = 0;
+    process->m_BlockQuota = (priority >= HIGH && priority <= LOWEST) ? USER_BLOCK_QUOTA : NUM_BLOCKS;
+    process->m_MemoryWaitTotal = 0;
+    process->m_MemoryWaitMax = 0;
+    process->m_HandedBlock = NULL;
+    process->m_Entry = entry;
+    initializeMailbox(&(process->m_Mailbox));
+    initializeContext(process);
+    return RTX_OK;
+}
+
+/**
+ * Sets the process' state to BLOCKED_RECEIVE, or from BLOCKED_RECEIVE to
+ * READY, keeping the blocked on receive bitmap in step.
+ */
+static void setBlockedOnReceive(PCB* process, int blocked) {
+    U32 bit = 0x80000000UL >> (process->m_PID % 32);
+
+    if (blocked) {
+        process->m_State = BLOCKED_RECEIVE;
+        s_BlockedOnReceive[process->m_PID / 32] |= bit;
+    } else {
+        process->m_State = READY;
+        s_BlockedOnReceive[process->m_PID / 32] &= ~bit;
+    }
+}
+
+/**
+ * Gets the process whose mailbox receives messages sent to the given ID: the
+ * process with that PID, or the task worker for a task ID.
+ *
+ * @return  The process, or NULL if no process or task has the ID. The task
+ *          worker's own PID gets NULL too, as it has no handler of its own.
+ */
+static PCB* getMailboxHolder(int id) {
+    if (id == TASK_WORKER) {
+        return NULL; // the worker only takes messages addressed to its tasks
+    } else if (id >= 0 && id < NUM_PROCS) {
+        return g_ProcessTable[id];
+    } else if (isTask(id)) {
+        return g_ProcessTable[TASK_WORKER];
+    }
+    return NULL;
+}
+
+/**
+ * Gets the ID that messages sent by the current process come from: the
+ * running task while the task worker dispatches, otherwise the PID.
+ */
+static int getSenderID(void) {
+    if (g_CurrentProcess->m_PID == TASK_WORKER) {
+        return getRunningTask();
+    }
+    return g_CurrentProcess->m_PID;
+}
+
+/**
+ * Returns the queue that holds a process in the given state, or NULL if
+ * processes in that state are not queued by priority.
+ */
+static PriorityQueue* getStateQueue(ProcessState state) {
+    if (state == NEW || state == READY) {
+        return &s_ReadyQueue;
+    } else if (state == BLOCKED_MEM) {
+        return &s_BlockedOnMemoryQueue;
+    }
+    return NULL;
+}
+
+#ifdef _STACK_CHECK
+/**
+ * Halts the system if the process has written to the lowest words of its
+ * stack. The stack below them belongs to another process or to the heap, so
+ * there is nothing safe to return to; the trace log records the culprit.
+ */
+static void checkStackGuard(PCB* process) {
+    int i;
+#ifdef DEBUG_0
+    char pid[4];
+#endif /* DEBUG_0 */
+
+    for (i = 0; i < STACK_GUARD_WORDS; i++) {
+        if (process->m_StackBase[i] != STACK_PAINT) {
+            trace(TRACE_STACK_OVERFLOW, process->m_PID, (U32)&(process->m_StackBase[i]));
+            __disable_irq();
+#ifdef DEBUG_0
+            // the debug log drains by interrupt, so poll the message out
+            strdecimal(process->m_PID, pid);
+            uart_put_string(1, (unsigned char*)"stack overflow: process ");
+            uart_put_string(1, (unsigned char*)pid);
+            uart_put_string(1, (unsigned char*)"\n\r");
+#endif /* DEBUG_0 */
+            while (1) {
+            }
+        }
+    }
+}
+#endif /* _STACK_CHECK */
+
+/**
+ * Reclaims the stack and PCB of a process that exited. Called once the
+ * processor has switched to another process' stack.
+ */
+static void reapExitedProcess(void) {
+    if (s_ExitedProcess != NULL) {
+        releaseStack(s_ExitedProcess->m_StackBase, s_ExitedProcess->m_StackSize);
+        enqueue(&s_FreeProcesses, s_ExitedProcess);
+        s_ExitedProcess = NULL;
+    }
+}
+
 // for process initialization
 extern PROC_INIT g_test_procs[NUM_TEST_PROCS];
 extern PROC_INIT g_StressProcesses[NUM_STRESS_PROCS];
@@ -59,23 +237,43 @@ extern PROC_INIT g_KCDProcess;
 extern PROC_INIT g_CRTProcess;
 extern PROC_INIT g_TimerProcess;
 extern PROC_INIT g_UARTProcess;
+extern PROC_INIT g_TaskWorker;
 extern PROC_INIT g_SetPriorityProcess;
 
 extern MemoryQueue g_Heap;
 extern volatile uint32_t g_timer_count;
 
+void c_PendSV_Handler(void) {
+    int delivered = serviceTimerMail(TIMER_DELIVERY_BUDGET);
+
+    // requeueing the current process for nothing would make every tick a
+    // time slice
+    if (delivered || s_SwitchRequested) {
+        s_SwitchRequested = 0;
+        k_release_processor();
+    }
+}
+
 int deliverMessage(int sourceProcess, int envelopeDestinationProcess, int destinationProcess, void* message, int delay) {
     Envelope* envelope;
-    PCB* destination = g_ProcessTable[destinationProcess];
+    PCB* destination = getMailboxHolder(destinationProcess);
+    PCB* recipient = getMailboxHolder(envelopeDestinationProcess);
     U32 node = (U32)message - sizeof(Envelope) - sizeof(Node); // for error checking
+
+    if (destination == NULL || recipient == NULL || recipient->m_State == EXITED) {
+        return RTX_ERR;
+    }
     
-    if (!isValidNode(&g_Heap, (Node*)node)) { // make sure it's a valid memory block
+    if (!isAllocatedBlock((Node*)node)) { // make sure it's a valid memory block
 // during performance testing, we repeatedly try to send a message using a dummy memory block
 // so the memory block will be invalid, but we want to send it anyway
 // so do not return here
 #ifndef DEBUG_PERFORMANCE
         return RTX_ERR;
 #endif /* DEBUG_PERFORMANCE */
+    } else {
+        ((Node*)node)->m_Owner = destination->m_PID; // the mailbox holder owns the block
+        ((Node*)node)->m_Acquired = g_timer_count;
     }
     
     node += sizeof(Node);
@@ -83,63 +281,212 @@ int deliverMessage(int sourceProcess, int envelopeDestinationProcess, int destin
     envelope->m_DestinationPID = envelopeDestinationProcess;
     envelope->m_SenderPID = sourceProcess;
     envelope->m_Expiry = g_timer_count + delay;
+    envelope->m_ExpiryOffset = 0;
+    envelope->m_Slack = 0;
+
+    if (delay == 0) {
+        trace(TRACE_SEND, sourceProcess, envelopeDestinationProcess);
+    } else {
+        trace(TRACE_DELAYED_SEND, envelopeDestinationProcess, delay);
+    }
     
-    return enqueueEnvelope(&(destination->m_Mailbox), envelope);
+    return postEnvelope(&(destination->m_Mailbox), envelope);
 }
 
-int handleMemoryRelease(int preempt) {
-    if (!isEmptyPriorityQueue(&s_BlockedOnMemoryQueue)) {
-        // clear blocked on memory queue, move processes to ready
-        PCB* process = dequeueHighest(&s_BlockedOnMemoryQueue);
-        if (process != NULL) {
-            process->m_State = READY;
-            enqueueAtPriority(&s_ReadyQueue, process);
-        }
-        if (preempt) {
-            return k_release_processor();
-        }
+int handleMemoryRelease(int processID, int preempt) {
+    PCB* process;
+    int outranked = 0;
+
+    // a process over its quota only waits for its own blocks
+    if (processID != NO_OWNER && g_ProcessTable[processID]->m_State == BLOCKED_QUOTA) {
+        process = g_ProcessTable[processID];
+        process->m_State = READY;
+        enqueueAtPriority(&s_ReadyQueue, process);
+        outranked = process->m_Priority < g_CurrentProcess->m_Priority;
+    }
+
+    // the freed block goes straight to the longest waiting of the highest
+    // priority waiters, so that no other process can take it first; one that
+    // could not use it stays blocked
+    process = peekHighest(&s_BlockedOnMemoryQueue);
+    if (process != NULL && handOverBlock(process)) {
+        dequeueHighest(&s_BlockedOnMemoryQueue);
+        process->m_State = READY;
+        enqueueAtPriority(&s_ReadyQueue, process);
+        outranked |= process->m_Priority < g_CurrentProcess->m_Priority;
+    }
+
+    // switching to a process that does not outrank this one gains nothing
+    if (outranked && preempt) {
+        return k_release_processor();
     }
     return RTX_OK;
 }
 
 int k_delayed_send(int process_id, void *message_envelope, int delay) {
-    return deliverMessage(g_CurrentProcess->m_PID, process_id, TIMER_IPROCESS, message_envelope, delay);
+    return deliverMessage(getSenderID(), process_id, TIMER_IPROCESS, message_envelope, delay);
+}
+
+int k_delayed_send_slack(int process_id, void* message_envelope, int delay, int slack) {
+    int result;
+
+    if (slack < 0 || slack > MAX_TIMER_SLACK) {
+        return RTX_ERR;
+    }
+
+    result = deliverMessage(getSenderID(), process_id, TIMER_IPROCESS, message_envelope, delay);
+    if (result == RTX_OK) {
+        ((Envelope*)((U32)message_envelope - sizeof(Envelope)))->m_Slack = slack;
+    }
+    return result;
+}
+
+int k_delayed_send_us(int process_id, void* message_envelope, int delay) {
+    int result;
+
+    if (delay < 0) {
+        return RTX_ERR;
+    }
+
+    result = deliverMessage(getSenderID(), process_id, TIMER_IPROCESS, message_envelope, 0);
+    if (result == RTX_OK) {
+        setHighResolutionExpiry((Envelope*)((U32)message_envelope - sizeof(Envelope)), delay);
+
+        // sort the message in now; waiting for the next tick would add up to a
+        // full millisecond of latency
+        if (serviceTimerMail(TIMER_DELIVERY_BUDGET)) {
+            return k_release_processor();
+        }
+    }
+    return result;
+}
+
+int k_create_process(void (*entry)(), int priority, int stack_size) {
+    PCB* process;
+    U32 criticalSection;
+
+    if (entry == NULL || priority < HIGH || priority > LOWEST || stack_size < MIN_STACK_SIZE) {
+        return RTX_ERR;
+    }
+
+    process = dequeue(&s_FreeProcesses);
+    if (process == NULL) {
+        return RTX_ERR;
+    }
+    if (initializeProcess(process, priority, stack_size, entry) != RTX_OK) {
+        enqueue(&s_FreeProcesses, process);
+        return RTX_ERR;
+    }
+    trace(TRACE_CREATE, process->m_PID, priority);
+
+    criticalSection = enterCriticalSection();
+    enqueueAtPriority(&s_ReadyQueue, process);
+    exitCriticalSection(criticalSection);
+
+    // the new process runs first if it outranks its creator
+    if (priority < g_CurrentProcess->m_Priority) {
+        k_release_processor();
+    }
+    return process->m_PID;
+}
+
+int k_exit_process(void) {
+    PCB* process = g_CurrentProcess;
+
+    // system processes run for the lifetime of the kernel
+    if (process->m_Priority < HIGH || process->m_Priority > LOWEST) {
+        return RTX_ERR;
+    }
+
+    // nothing may post to the process while its resources are released
+    enterCriticalSection();
+    process->m_State = EXITED;
+    trace(TRACE_EXIT, process->m_PID, 0);
+
+    cancelTimerMail(process->m_PID);
+    releaseProcessMemory(process->m_PID);
+    initializeMailbox(&(process->m_Mailbox));
+    removeProcessCommands(process->m_PID);
+    removeFrameReceiver(process->m_PID);
+
+    // the stack is still in use until the switch completes
+    s_ExitedProcess = process;
+    return k_release_processor(); // never returns to the exited process
 }
 
 int k_get_process_priority(int process_id) {
-    if (process_id <= 0 || process_id >= NUM_PROCS) { // cannot get priority of null process
+    if (isTask(process_id)) { // tasks run at the priority of their worker
+        return g_ProcessTable[TASK_WORKER]->m_Priority;
+    }
+    if (process_id <= 0 || process_id >= NUM_PROCS || g_ProcessTable[process_id]->m_State == EXITED) { // cannot get priority of null process
         return RTX_ERR;
     }
     return g_ProcessTable[process_id]->m_Priority;
 }
 
+int k_get_stack_usage(int process_id, int* stack_size) {
+    PCB* process;
+    U32* word;
+
+    if (process_id < 0 || process_id >= NUM_PROCS || g_ProcessTable[process_id]->m_State == EXITED) {
+        return RTX_ERR;
+    }
+
+    process = g_ProcessTable[process_id];
+    word = process->m_StackBase;
+    while (word < (U32*)((U32)process->m_StackBase + process->m_StackSize) && *word == STACK_PAINT) {
+        word++;
+    }
+
+    if (stack_size != NULL) {
+        *stack_size = process->m_StackSize;
+    }
+    return (U32)process->m_StackBase + process->m_StackSize - (U32)word;
+}
+
 void* k_receive_message(int* sender_id) {
     Envelope * envelope;
     
-    while (isEmptyMessageQueue(&(g_CurrentProcess->m_Mailbox))) {
-        g_CurrentProcess->m_State = BLOCKED_RECEIVE;
+    while (isEmptyMailbox(&(g_CurrentProcess->m_Mailbox))) {
+        setBlockedOnReceive(g_CurrentProcess, 1);
         k_release_processor();
     }
     
-    envelope = dequeueEnvelope(&(g_CurrentProcess->m_Mailbox));
+    envelope = takeEnvelope(&(g_CurrentProcess->m_Mailbox));
     if (sender_id != NULL) {
         *sender_id = envelope->m_SenderPID; // return ID of sender
     }
+    trace(TRACE_RECEIVE, g_CurrentProcess->m_PID, envelope->m_SenderPID);
     
     return (void*)((U32)envelope + sizeof(Envelope)); // return the envelope offset by the size of Envelope
 }
 
+void* k_poll_message(int* sender_id) {
+    return nonBlockingReceiveMessage(g_CurrentProcess->m_PID, sender_id);
+}
+
 int k_release_processor(void) {
     return process_switch(); 
 }
 
+int releaseProcessorFromInterrupt(void) {
+    // only switch if the interrupt preempted a process; if it preempted the
+    // deferred context, let PendSV reschedule once it finishes
+    if (SCB->ICSR & SCB_ICSR_RETTOBASE_Msk) {
+        return k_release_processor();
+    }
+    s_SwitchRequested = 1;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    return RTX_OK;
+}
+
 int k_send_message(int process_id, void *message_envelope) {
-    PCB* destination = g_ProcessTable[process_id];
-    int result = deliverMessage(g_CurrentProcess->m_PID, process_id, process_id, message_envelope, 0);
+    PCB* destination = getMailboxHolder(process_id);
+    int result = deliverMessage(getSenderID(), process_id, process_id, message_envelope, 0);
     
     // if the destination process is blocked on receive, unblock it
-    if (destination->m_State == BLOCKED_RECEIVE) {
-        destination->m_State = READY;
+    if (result == RTX_OK && destination->m_State == BLOCKED_RECEIVE) {
+        setBlockedOnReceive(destination, 0);
         enqueueAtPriority(&s_ReadyQueue, destination);
         
         // preempt current process if destination process has higher priority and is blocked on receive
@@ -154,19 +501,23 @@ int k_send_message(int process_id, void *message_envelope) {
 }
 
 int k_set_process_priority(int process_id, int priority) {
-    int oldPriority;
-    int i;
+    PCB* process;
+    PriorityQueue* queue;
 
-    if (process_id <= NULL_PROCESS || process_id > (NUM_TEST_PROCS + NUM_STRESS_PROCS)) { // cannot change priority of system processes
+    if (process_id <= NULL_PROCESS || process_id >= NUM_PROCS) {
         return RTX_ERR;
     }
     if (priority < HIGH || priority > LOWEST) { // cannot change to PRIVILEGED or NULL_PRIORITY
         return RTX_ERR;
     }
 
-    oldPriority = g_ProcessTable[process_id]->m_Priority;
+    process = g_ProcessTable[process_id];
+    // system processes run at PRIVILEGED or NULL_PRIORITY and keep it
+    if (process->m_State == EXITED || process->m_Priority < HIGH || process->m_Priority > LOWEST) {
+        return RTX_ERR;
+    }
 
-    if (oldPriority == priority) {
+    if (process->m_Priority == priority) {
         // expected behaviour:
         // if there is no change in priority, the current process is not preempted
         // and the specified process retains its position in the priority queue
@@ -175,30 +526,64 @@ int k_set_process_priority(int process_id, int priority) {
 
     // if the current process is the specified process,
     // change its priority and preempt it
-    if (g_CurrentProcess->m_PID == process_id) {
-        g_CurrentProcess->m_Priority = priority;
+    if (g_CurrentProcess == process) {
+        process->m_Priority = priority;
         return k_release_processor();
     }
     
     // handle changing priority of a blocked on receive process
     // (blocked on receive processes are not in any priority queue)
-    if (g_ProcessTable[process_id]->m_State == BLOCKED_RECEIVE) {
-        g_ProcessTable[process_id]->m_Priority = priority;
+    queue = getStateQueue(process->m_State);
+    if (queue == NULL) {
+        process->m_Priority = priority;
         return RTX_OK; // should this case preempt?
-    } else { // if the specified process is currently queued
-        for (i = 0; i < QUEUED_STATES; i++) {
-            if (updateProcessPriority(s_MasterPQs[i], process_id, oldPriority, priority)) {
-                k_release_processor(); // allow the processor to preempt the current process if it wants to
-                return RTX_OK;
-            }
-        }
+    } else if (updateProcessPriority(queue, process, priority)) {
+        k_release_processor(); // allow the processor to preempt the current process if it wants to
+        return RTX_OK;
     }
     
     return RTX_ERR;
 }
 
+int startTaskWorker(void) {
+    PCB* worker = g_ProcessTable[TASK_WORKER];
+    U32 criticalSection;
+
+    if (worker->m_State != EXITED) {
+        return RTX_OK;
+    }
+    if (initializeProcess(worker, g_TaskWorker.m_priority, g_TaskWorker.m_stack_size, g_TaskWorker.mpf_start_pc) != RTX_OK) {
+        return RTX_ERR;
+    }
+
+    criticalSection = enterCriticalSection();
+    enqueueAtPriority(&s_ReadyQueue, worker);
+    exitCriticalSection(criticalSection);
+    return RTX_OK;
+}
+
+int restartProcess(PCB* process) {
+    PriorityQueue* queue = getStateQueue(process->m_State);
+    int released;
+
+    // take it off whatever it was waiting in
+    if (queue != NULL) {
+        removeAtPriority(queue, process);
+    } else if (process->m_State == BLOCKED_RECEIVE) {
+        setBlockedOnReceive(process, 0);
+    }
+
+    cancelTimerMail(process->m_PID);
+    released = releaseProcessMemory(process->m_PID);
+    trace(TRACE_RESTART, process->m_PID, released);
+    initializeMailbox(&(process->m_Mailbox));
+    initializeContext(process);
+    enqueueAtPriority(&s_ReadyQueue, process);
+    return released;
+}
+
 void* nonBlockingReceiveMessage(int receiverID, int* senderIDOutput) {
-    Envelope* envelope = dequeueEnvelope(&(g_ProcessTable[receiverID]->m_Mailbox));
+    Envelope* envelope = takeEnvelope(&(g_ProcessTable[receiverID]->m_Mailbox));
     if (senderIDOutput != NULL) {
         *senderIDOutput = (envelope == NULL) ? -1 : envelope->m_SenderPID;
     }
@@ -206,12 +591,12 @@ void* nonBlockingReceiveMessage(int receiverID, int* senderIDOutput) {
 }
 
 int nonPreemptiveSendMessage(int sourceID, int destinationID, void* message) {
-    PCB* destination = g_ProcessTable[destinationID];
+    PCB* destination = getMailboxHolder(destinationID);
     int result = deliverMessage(sourceID, destinationID, destinationID, message, 0);
     
     // if the destination process is blocked on receive, unblock it
-    if (destination->m_State == BLOCKED_RECEIVE) {
-        destination->m_State = READY;
+    if (result == RTX_OK && destination->m_State == BLOCKED_RECEIVE) {
+        setBlockedOnReceive(destination, 0);
         enqueueAtPriority(&s_ReadyQueue, destination);
     }
     
@@ -220,7 +605,6 @@ int nonPreemptiveSendMessage(int sourceID, int destinationID, void* message) {
 
 void process_init() {
     int i;
-    U32 *sp;
 
     // initialize processes
     initializeSetPriorityProcess();
@@ -228,6 +612,7 @@ void process_init() {
     initializeSystemProcesses();
     initializeTimerProcess();
     initializeUARTProcess();
+    initializeTaskWorker();
     
     set_test_procs();
     setStressTestProcesses();
@@ -268,6 +653,11 @@ void process_init() {
     g_proc_table[UART_IPROCESS].m_stack_size = g_UARTProcess.m_stack_size;
     g_proc_table[UART_IPROCESS].mpf_start_pc = g_UARTProcess.mpf_start_pc;
 
+    g_proc_table[TASK_WORKER].m_pid = g_TaskWorker.m_pid;
+    g_proc_table[TASK_WORKER].m_priority = g_TaskWorker.m_priority;
+    g_proc_table[TASK_WORKER].m_stack_size = g_TaskWorker.m_stack_size;
+    g_proc_table[TASK_WORKER].mpf_start_pc = g_TaskWorker.mpf_start_pc;
+
     // test processes
     for (i = 1; i <= NUM_TEST_PROCS; i++) {
         g_proc_table[i].m_pid = g_test_procs[i - 1].m_pid;
@@ -285,23 +675,32 @@ void process_init() {
     }
 
     // initialize exception stack frame (i.e. initial context) for each process
-    for ( i = 0; i < NUM_PROCS; i++ ) {
-        int j;
+    for ( i = 0; i < NUM_BOOT_PROCS; i++ ) {
         (g_ProcessTable[i])->m_PID = (g_proc_table[i]).m_pid;
-        (g_ProcessTable[i])->m_Priority = (g_proc_table[i]).m_priority;
-        (g_ProcessTable[i])->m_State = NEW;
-        initializeMessageQueue(&((g_ProcessTable[i])->m_Mailbox));
-
-        sp = alloc_stack((g_proc_table[i]).m_stack_size);
-        *(--sp)  = INITIAL_xPSR; // user process initial xPSR
-        *(--sp)  = (U32)((g_proc_table[i]).mpf_start_pc); // PC contains the entry point of the process
-        for ( j = 0; j < 6; j++ ) { // R0-R3, R12 are cleared with 0
-            *(--sp) = 0x0;
+        if (i == TASK_WORKER) { // started by the first create_task()
+            (g_ProcessTable[i])->m_Priority = g_TaskWorker.m_priority;
+            (g_ProcessTable[i])->m_State = EXITED;
+            initializeMailbox(&((g_ProcessTable[i])->m_Mailbox));
+            continue;
         }
-        (g_ProcessTable[i])->m_ProcessSP = sp;
+        initializeProcess(g_ProcessTable[i], (g_proc_table[i]).m_priority, (g_proc_table[i]).m_stack_size, (g_proc_table[i]).mpf_start_pc);
+    }
+
+    // the rest of the process table is free for create_process()
+    initializeQueue(&s_FreeProcesses);
+    s_ExitedProcess = NULL;
+    s_SwitchRequested = 0;
+    for ( i = NUM_BOOT_PROCS; i < NUM_PROCS; i++ ) {
+        (g_ProcessTable[i])->m_PID = i;
+        (g_ProcessTable[i])->m_State = EXITED;
+        initializeMailbox(&((g_ProcessTable[i])->m_Mailbox));
+        enqueue(&s_FreeProcesses, g_ProcessTable[i]);
     }
 
     // initialize priority queues
+    for (i = 0; i < (NUM_PROCS + 31) / 32; i++) {
+        s_BlockedOnReceive[i] = 0;
+    }
     initializePriorityQueue(&s_ReadyQueue);
     initializePriorityQueue(&s_BlockedOnMemoryQueue);
 
@@ -309,8 +708,10 @@ void process_init() {
     s_MasterPQs[1] = &s_BlockedOnMemoryQueue;
 
     // all processes are currently new and ready
-    for (i = 0; i < NUM_PROCS - NUM_IPROCS; i++) {
-        enqueueAtPriority(&s_ReadyQueue, g_ProcessTable[i]);
+    for (i = 0; i < NUM_BOOT_PROCS; i++) {
+        if (!isIProcess(i) && i != TASK_WORKER) {
+            enqueueAtPriority(&s_ReadyQueue, g_ProcessTable[i]);
+        }
     }
 
     // no running process
@@ -320,10 +721,14 @@ void process_init() {
 int process_switch() {
     PCB* oldProcess;
 
+    // interrupt handlers may preempt the deferred context, so mask them while
+    // the queues and the stack pointer are inconsistent
+    enterCriticalSection();
+
     if (g_CurrentProcess != NULL) {
         // if current process is an i-process, don't add it to any priority queue
         // else, add process to appropriate queue and save context
-        if (g_CurrentProcess->m_State == BLOCKED_RECEIVE) {
+        if (g_CurrentProcess->m_State == BLOCKED_RECEIVE || g_CurrentProcess->m_State == BLOCKED_QUOTA || g_CurrentProcess->m_State == EXITED) {
         } else if (g_CurrentProcess->m_State == BLOCKED_MEM) { // blocked on memory
             enqueueAtPriority(&s_BlockedOnMemoryQueue, g_CurrentProcess);
         } else { // ready
@@ -337,26 +742,36 @@ int process_switch() {
 
     // save context of old process if we're actually switching
     if (g_CurrentProcess != oldProcess) {
+        trace(TRACE_SWITCH, (oldProcess == NULL) ? NULL_PROCESS : oldProcess->m_PID, g_CurrentProcess->m_PID);
         if (oldProcess != NULL) {
             oldProcess->m_ProcessSP = (U32 *)__get_MSP();
+#ifdef _STACK_CHECK
+            checkStackGuard(oldProcess);
+#endif /* _STACK_CHECK */
         }
         
         if (g_CurrentProcess->m_State == READY || g_CurrentProcess->m_State == NEW) {
             ProcessState state = g_CurrentProcess->m_State;
             g_CurrentProcess->m_State = RUNNING;
             __set_MSP((U32) g_CurrentProcess->m_ProcessSP); // switch to the new processes's stack
+            reapExitedProcess(); // the old stack is no longer in use
 
             if (state == NEW) {
+                exitCriticalSection(0);
                 __rte(); // pop exception stack frame from the stack for new processes
             }
         } else { // if the scheduler chose a process that isn't READY or NEW, something broke
             g_CurrentProcess = oldProcess;
+            exitCriticalSection(0);
             return RTX_ERR;
         }
     } else {
         g_CurrentProcess->m_State = RUNNING;
     }
 
+    // the saved BASEPRI belongs to the old process' frame, so restore the
+    // level every caller runs at instead
+    exitCriticalSection(0);
     return RTX_OK;
 }
 
@@ -368,20 +783,18 @@ void serializeQueue(char debugInfo[], int start, int queueNumber){
     int j = start;
     if (queueNumber == 2) { // blocked on receive, special case
         int i;
-        for ( i = 0; i < NUM_PROCS; i++ ) {
-            if (g_ProcessTable[i]->m_State == BLOCKED_RECEIVE) {
+        for ( i = 0; i < (NUM_PROCS + 31) / 32; i++ ) {
+            U32 blocked = s_BlockedOnReceive[i];
+            while (blocked != 0) {
+                PCB* process = g_ProcessTable[i * 32 + __CLZ(blocked)];
+                blocked &= ~(0x80000000UL >> __CLZ(blocked));
+
                 debugInfo[j] = '(';
                 j++;
-                if (g_ProcessTable[i]->m_PID / 10 > 0) {// assuming less than 99 processes
-                    debugInfo[j] = (g_ProcessTable[i]->m_PID/10) + '0';
-                    j++;
-                }
-                debugInfo[j] = (g_ProcessTable[i]->m_PID % 10) + '0';
-                j++;
+                j += strdecimal(process->m_PID, &debugInfo[j]);
                 debugInfo[j] = ',';
                 j++;
-                debugInfo[j] = g_ProcessTable[i]->m_Priority + '0';
-                j++;
+                j += strdecimal(process->m_Priority, &debugInfo[j]);
                 debugInfo[j] = ')';
                 j++;
                 debugInfo[j] = '\r';
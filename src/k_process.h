@@ -9,6 +9,13 @@
 #include "Utilities/k_rtx.h"
 #include "Utilities/PriorityQueue.h"
 
+/**
+ * Deferred kernel context, run from PendSV at the lowest interrupt priority.
+ * Sorts and delivers delayed mail handed off by the timer interrupt, then
+ * reschedules if it delivered any or an interrupt asked for a switch.
+ */
+void c_PendSV_Handler(void);
+
 /**
  * Adds an envelope to the message queue of the specified process. This is a
  * helper function for IPC.
@@ -26,13 +33,32 @@
 int deliverMessage(int sourceProcess, int envelopeDestinationProcess, int destinationProcess, void* message, int delay);
 
 /**
- * Handles a release memory block event. This function preempts if specified.
+ * Handles a release memory block event: readies the process the block was
+ * charged to if it was over its quota, and hands a free block to the highest
+ * priority process blocked on memory. This function preempts if specified and
+ * a readied process outranks the current one.
  * 
+ * @param   processID The ID of the process the block was charged to, or
+ *                    NO_OWNER. It is readied if it was blocked on its quota.
  * @param   preempt 1 if this function should be allowed to preempt the current
  *                  process.
  * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
  */
-int handleMemoryRelease(int preempt);
+int handleMemoryRelease(int processID, int preempt);
+
+/**
+ * Creates a process at a user priority (HIGH to LOWEST), using a free entry
+ * of the process table. The new process preempts the caller if it has a
+ * higher priority.
+ * 
+ * @param   entry The function the process starts running.
+ * @param   priority The priority of the process.
+ * @param   stack_size The size of the process stack in bytes (at least
+ *                     MIN_STACK_SIZE).
+ * @return  The ID of the new process, or RTX_ERR if the arguments are invalid
+ *          or no process table entry or stack space is available.
+ */
+int k_create_process(void (*entry)(), int priority, int stack_size);
 
 /**
  * Sends a message to the specified process after a delay.
@@ -45,6 +71,44 @@ int handleMemoryRelease(int preempt);
  */
 int k_delayed_send(int process_id, void* message_envelope, int delay);
 
+/**
+ * Sends a message to the specified process after a delay, allowing the timer
+ * to hold it for up to slack milliseconds longer. Messages whose windows
+ * overlap are delivered in a single pass with a single reschedule.
+ * 
+ * @param   process_id The ID of the receiving process.
+ * @param   message_envelope The message to send.
+ * @param   delay The minimum amount of time in milliseconds to wait before
+ *                sending the message.
+ * @param   slack The additional time in milliseconds (at most
+ *                MAX_TIMER_SLACK) the message may be held.
+ * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
+ */
+int k_delayed_send_slack(int process_id, void* message_envelope, int delay, int slack);
+
+/**
+ * Sends a message to the specified process after a delay given in
+ * microseconds. The timer i-process programs a spare match register for the
+ * earliest pending expiry, so delays are not quantized to the 1 ms tick.
+ * 
+ * @param   process_id The ID of the receiving process.
+ * @param   message_envelope The message to send.
+ * @param   delay The amount of time in microseconds to wait before sending the
+ *                message.
+ * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
+ */
+int k_delayed_send_us(int process_id, void* message_envelope, int delay);
+
+/**
+ * Terminates the calling process. Its pending delayed messages, mailbox
+ * contents and held memory blocks are released, and its stack and process
+ * table entry are reclaimed for later create_process() calls. Processes at
+ * system priorities cannot exit.
+ * 
+ * @return  Does not return on success; RTX_ERR if the process cannot exit.
+ */
+int k_exit_process(void);
+
 /**
  * Gets the priority of the specified process.
  * 
@@ -53,6 +117,19 @@ int k_delayed_send(int process_id, void* message_envelope, int delay);
  */
 int k_get_process_priority(int process_id);
 
+/**
+ * Gets the high-water mark of a process' stack. Stacks are painted with
+ * STACK_PAINT when the process is created, so the mark is the distance from
+ * the top of the stack to the lowest word that no longer holds the pattern.
+ * 
+ * @param   process_id The ID of the process of interest.
+ * @param   stack_size If not NULL, the size of the stack in bytes is written
+ *                     into this address.
+ * @return  The most stack the process has used in bytes, or RTX_ERR if there
+ *          is no such process.
+ */
+int k_get_stack_usage(int process_id, int* stack_size);
+
 /**
  * Gets a message from the calling process' mailbox if a message is waiting.
  * This primitive is blocking.
@@ -62,6 +139,15 @@ int k_get_process_priority(int process_id);
  */
 void* k_receive_message(int* sender_id);
 
+/**
+ * Gets a message from the calling process' mailbox if a message is waiting.
+ * This primitive is non-blocking.
+ * 
+ * @param   sender_id The ID of the sender is written into this address.
+ * @return  A pointer to the message, or NULL if the mailbox is empty.
+ */
+void* k_poll_message(int* sender_id);
+
 /**
  * Releases the processor to give the kernel a chance to schedule another
  * process.
@@ -70,17 +156,27 @@ void* k_receive_message(int* sender_id);
  */
 int k_release_processor(void);
 
+/**
+ * Releases the processor from an interrupt handler. If the interrupt
+ * preempted the deferred context instead of a process, the reschedule is left
+ * to PendSV.
+ * 
+ * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
+ */
+int releaseProcessorFromInterrupt(void);
+
 /**
  * Sends a message to the specified process. This primitive is preemptive.
  * 
- * @param   process_id The ID of the receiving process.
+ * @param   process_id The ID of the receiving process or task.
  * @param   message_envelope The message to send.
  * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
  */
 int k_send_message(int process_id, void* message_envelope);
 
 /**
- * Sets the priority of the specified process.
+ * Sets the priority of the specified process. Only processes at a user
+ * priority (HIGH to LOWEST) can be changed, and only to a user priority.
  * 
  * @param   process_id The ID of the process to change.
  * @param   priority The new priority to change to.
@@ -115,11 +211,34 @@ void process_init(void);
 
 /**
  * Switches the current process with another process picked by the scheduler.
+ * Must be called outside any critical section; kernel interrupts are masked
+ * during the switch.
  * 
  * @return  The success (RTX_OK) or failure (RTX_ERR) of the operation.
  */
 int process_switch(void);
 
+/**
+ * Restarts a process that is not running from its entry point: takes it off
+ * the queue it waits in, discards its delayed mail, releases every memory
+ * block it holds, including its mailbox, and rebuilds its initial context.
+ * Its priority and quota are kept. Must be called with kernel interrupts
+ * masked. This is non-preemptive.
+ * 
+ * @param   process The process to restart.
+ * @return  The number of memory blocks released.
+ */
+int restartProcess(PCB* process);
+
+/**
+ * Starts the task worker process, which is not created at boot so that its
+ * stack is only allocated once there are tasks. Does nothing if it is already
+ * running. This is non-preemptive.
+ * 
+ * @return  RTX_OK, or RTX_ERR if there is no room for its stack.
+ */
+int startTaskWorker(void);
+
 /**
  * Picks the next to run process based on process priority.
  * 
@@ -7,23 +7,33 @@
 
 #include "k_rtx_init.h"
 
+#include "DebugLog.h"
+#include "k_critical.h"
 #include "k_memory.h"
 #include "k_process.h"
 #include "Timer.h"
+#include "Trace.h"
 #include "UART.h"
 
 void k_rtx_init(void) {
-    __disable_irq();
+    U32 criticalSection = enterCriticalSection();
+    
+    initializeTrace();
+    initializeInterruptPriorities();
     
 #ifndef DEBUG_PERFORMANCE // disable primary timer interrupts during performance testing
     timer_init(0); // initialize timer 0
 #endif /* !DEBUG_PERFORMANCE */
     timer_init(1); // initialize timer 1
     uart0_irq_init(); // uart0 interrupt driven, for RTX console
+#if defined(DEBUG_0) || defined(DEBUG_PERFORMANCE)
+    initializeDebugLog(); // uart1 interrupt driven, buffered debug output
+#else
     uart1_polling_init(); // uart1 polling, for debugging
+#endif /* DEBUG_0 || DEBUG_PERFORMANCE */
     memory_init();
     process_init();
-    __enable_irq();
+    exitCriticalSection(criticalSection);
 
     // start the first process
     k_release_processor();
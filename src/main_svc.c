@@ -6,10 +6,10 @@
  * NOTE: standard C library is not allowed in the final kernel code.
  *       A tiny printf function for embedded application development
  *       taken from http://www.sparetimelabs.com/tinyprintf/tinyprintf.php
- *       is configured to use UART0 to output when DEBUG_0 is defined.
- *       Check target option->C/C++ to see the DEBUG_0 definition.
- *       Note that init_printf(NULL, putc) must be called to initialize 
- *       the printf function.
+ *       is configured to write into the buffered UART1 debug log when
+ *       DEBUG_0 is defined. Check target option->C/C++ to see the DEBUG_0
+ *       definition. Note that init_printf(NULL, logPutc) must be called to
+ *       initialize the printf function.
  */
 
 #include <LPC17xx.h>
@@ -19,8 +19,10 @@
 #include "rtx.h"
 
 #ifdef DEBUG_0
+#include "DebugLog.h"
 #include "printf.h"
 #elif DEBUG_PERFORMANCE
+#include "DebugLog.h"
 #include "printf.h"
 #endif /* DEBUG_0 || DEBUG_PERFORMANCE */
 
@@ -29,9 +31,9 @@ int main() {
 	SystemInit(); 
 
 #ifdef DEBUG_0
-	init_printf(NULL, putc);
+	init_printf(NULL, logPutc);
 #elif DEBUG_PERFORMANCE
-    init_printf(NULL, putc);
+    init_printf(NULL, logPutc);
 #endif /* DEBUG_0 || DEBUG_PERFORMANCE */
 
 	/* start the RTX and built-in processes */
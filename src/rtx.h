@@ -38,6 +38,38 @@ extern int k_release_memory_block(void *);
 #define release_memory_block(p_mem_blk) _release_memory_block((U32)k_release_memory_block, p_mem_blk)
 extern int _release_memory_block(U32 p_func, void *p_mem_blk) __SVC_0;
 
+extern int k_get_memory_usage(int process_id, int *quota);
+#define get_memory_usage(process_id, quota) _get_memory_usage((U32)k_get_memory_usage, process_id, quota)
+extern int _get_memory_usage(U32 p_func, int process_id, int *quota) __SVC_0;
+
+extern int k_get_memory_stats(int process_id, MemoryStats *stats);
+#define get_memory_stats(process_id, stats) _get_memory_stats((U32)k_get_memory_stats, process_id, stats)
+extern int _get_memory_stats(U32 p_func, int process_id, MemoryStats *stats) __SVC_0;
+
+extern int k_get_owned_blocks(int process_id);
+#define get_owned_blocks(process_id) _get_owned_blocks((U32)k_get_owned_blocks, process_id)
+extern int _get_owned_blocks(U32 p_func, int process_id) __SVC_0;
+
+extern int k_get_oldest_blocks(BlockInfo info[], int count);
+#define get_oldest_blocks(info, count) _get_oldest_blocks((U32)k_get_oldest_blocks, info, count)
+extern int _get_oldest_blocks(U32 p_func, BlockInfo info[], int count) __SVC_0;
+
+extern int k_reclaim_memory(int process_id);
+#define reclaim_memory(process_id) _reclaim_memory((U32)k_reclaim_memory, process_id)
+extern int _reclaim_memory(U32 p_func, int process_id) __SVC_0;
+
+extern int k_set_memory_quota(int process_id, int quota);
+#define set_memory_quota(process_id, quota) _set_memory_quota((U32)k_set_memory_quota, process_id, quota)
+extern int _set_memory_quota(U32 p_func, int process_id, int quota) __SVC_0;
+
+extern int k_set_memory_watermarks(int low, int high);
+#define set_memory_watermarks(low, high) _set_memory_watermarks((U32)k_set_memory_watermarks, low, high)
+extern int _set_memory_watermarks(U32 p_func, int low, int high) __SVC_0;
+
+extern int k_subscribe_memory_pressure(int subscribe);
+#define subscribe_memory_pressure(subscribe) _subscribe_memory_pressure((U32)k_subscribe_memory_pressure, subscribe)
+extern int _subscribe_memory_pressure(U32 p_func, int subscribe) __SVC_0;
+
 // Process Management
 extern int k_set_process_priority(int process_id, int priority);
 #define set_process_priority(process_id, priority) _set_process_priority((U32)k_set_process_priority, process_id, priority)
@@ -47,15 +79,47 @@ extern int k_get_process_priority(int process_id);
 #define get_process_priority(process_id) _get_process_priority((U32)k_get_process_priority, process_id)
 extern int _get_process_priority(U32 p_func, int process_id) __SVC_0;
 
+extern int k_get_stack_usage(int process_id, int *stack_size);
+#define get_stack_usage(process_id, stack_size) _get_stack_usage((U32)k_get_stack_usage, process_id, stack_size)
+extern int _get_stack_usage(U32 p_func, int process_id, int *stack_size) __SVC_0;
+
+extern int k_create_process(void (*entry)(), int priority, int stack_size);
+#define create_process(entry, priority, stack_size) _create_process((U32)k_create_process, entry, priority, stack_size)
+extern int _create_process(U32 p_func, void (*entry)(), int priority, int stack_size) __SVC_0;
+
+extern int k_create_task(void (*handler)(void *message, int sender_id));
+#define create_task(handler) _create_task((U32)k_create_task, handler)
+extern int _create_task(U32 p_func, void (*handler)(void *message, int sender_id)) __SVC_0;
+
+extern int k_exit_process(void);
+#define exit_process() _exit_process((U32)k_exit_process)
+extern int _exit_process(U32 p_func) __SVC_0;
+
 // IPC Management
 extern void *k_receive_message(int *sender_id);
 #define receive_message(sender_id) _receive_message((U32)k_receive_message, sender_id)
 extern void *_receive_message(U32 p_func, int *sender_id) __SVC_0;
 
+extern void *k_poll_message(int *sender_id);
+#define poll_message(sender_id) _poll_message((U32)k_poll_message, sender_id)
+extern void *_poll_message(U32 p_func, int *sender_id) __SVC_0;
+
 extern int k_delayed_send(int process_id, void *message_envelope, int delay);
 #define delayed_send(process_id, message_envelope, delay) _delayed_send((U32)k_delayed_send, process_id, message_envelope, delay)
 extern int _delayed_send(U32 p_func, int process_id, void *message_envelope, int delay) __SVC_0;
 
+extern int k_delayed_send_slack(int process_id, void *message_envelope, int delay, int slack);
+#define delayed_send_slack(process_id, message_envelope, delay, slack) _delayed_send_slack((U32)k_delayed_send_slack, process_id, message_envelope, delay, slack)
+extern int _delayed_send_slack(U32 p_func, int process_id, void *message_envelope, int delay, int slack) __SVC_0;
+
+extern int k_delayed_send_us(int process_id, void *message_envelope, int delay);
+#define delayed_send_us(process_id, message_envelope, delay) _delayed_send_us((U32)k_delayed_send_us, process_id, message_envelope, delay)
+extern int _delayed_send_us(U32 p_func, int process_id, void *message_envelope, int delay) __SVC_0;
+
+extern int k_register_frame_receiver(void);
+#define register_frame_receiver() _register_frame_receiver((U32)k_register_frame_receiver)
+extern int _register_frame_receiver(U32 p_func) __SVC_0;
+
 extern int k_send_message(int process_id, void *message_envelope);
 #define send_message(process_id, message_envelope) _send_message((U32)k_send_message, process_id, message_envelope)
 extern int _send_message(U32 p_func, int process_id, void *message_envelope) __SVC_0;
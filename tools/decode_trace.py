@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Decodes the kernel's binary trace log (see src/Trace.h).
+
+The input is a memory dump containing g_TraceLog, either raw binary or
+Intel HEX (as written by the uVision debugger command
+"SAVE trace.hex &g_TraceLog, &g_TraceLog + sizeof(g_TraceLog) - 1").
+The log is located by its magic word, so dumping all of RAM works too.
+
+usage: decode_trace.py <dump> [path/to/Trace.h] [path/to/Definitions.h]
+"""
+
+import os
+import re
+import struct
+import sys
+
+SRC = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'src')
+TRACE_MAGIC = 0x45435254
+
+
+def read_formats(trace_header):
+    """Returns the event format strings, indexed by event ID."""
+    text = open(trace_header).read()
+    return [fmt.replace('%u', '%d') for fmt in
+            re.findall(r'TRACE_EVENT\(\s*\w+\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', text)]
+
+
+def read_log_size(definitions_header):
+    text = open(definitions_header).read()
+    return int(re.search(r'#define\s+TRACE_LOG_SIZE\s+(\d+)', text).group(1))
+
+
+def read_dump(path):
+    """Returns the dump contents as bytes (gaps in Intel HEX are zero-filled)."""
+    data = open(path, 'rb').read()
+    if not data.startswith(b':'):
+        return data
+
+    memory = {}
+    upper = 0
+    for line in data.decode('ascii').split():
+        count = int(line[1:3], 16)
+        address = int(line[3:7], 16)
+        kind = int(line[7:9], 16)
+        payload = bytes.fromhex(line[9:9 + 2 * count])
+        if kind == 0:
+            for i, byte in enumerate(payload):
+                memory[upper + address + i] = byte
+        elif kind == 4:
+            upper = int.from_bytes(payload, 'big') << 16
+    base = min(memory)
+    return bytes(memory.get(a, 0) for a in range(base, max(memory) + 1))
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    formats = read_formats(sys.argv[2] if len(sys.argv) > 2 else os.path.join(SRC, 'Trace.h'))
+    size = read_log_size(sys.argv[3] if len(sys.argv) > 3 else os.path.join(SRC, 'Utilities', 'Definitions.h'))
+    dump = read_dump(sys.argv[1])
+
+    start = dump.find(struct.pack('<I', TRACE_MAGIC))
+    if start < 0:
+        sys.exit('trace log not found in dump')
+    count, = struct.unpack_from('<I', dump, start + 4)
+
+    for index in range(max(0, count - size), count):
+        header, time, first, second = struct.unpack_from('<4I', dump, start + 8 + 16 * (index % size))
+        event, micros = header >> 16, header & 0xFFFF
+        if event < len(formats):
+            # formats may use fewer than both words (e.g. TRACE_EXIT)
+            conversions = len(re.findall(r'%[^%]', formats[event].replace('%%', '')))
+            text = formats[event] % (first, second)[:conversions]
+        else:
+            text = 'unknown event %d (0x%08x, 0x%08x)' % (event, first, second)
+        print('%10d.%03d ms  %s' % (time, micros, text))
+
+
+if __name__ == '__main__':
+    main()